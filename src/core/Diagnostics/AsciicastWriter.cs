@@ -0,0 +1,118 @@
+// SPDX-License-Identifier: 0BSD
+
+using System.Text.Encodings.Web;
+using System.Text.Json;
+
+namespace Vezel.Cathode.Diagnostics;
+
+// Writes the asciicast v2 format: https://docs.asciinema.org/manual/asciicast/v2.
+[SuppressMessage("", "CA1001")]
+internal sealed class AsciicastWriter
+{
+    // Buffered events are written out once they exceed this size. It is arbitrary and only affects performance.
+    public const int FlushThreshold = 64 * 1024;
+
+    public int BufferedCount => _buffer.WrittenCount;
+
+    private readonly ArrayBufferWriter<byte> _buffer = new();
+
+    private readonly Utf8JsonWriter _json;
+
+    // Output and input are separate byte streams, so a UTF-8 sequence split across two writes must only be joined with
+    // the rest of the same stream.
+    private readonly Decoder _outputDecoder = Terminal.Encoding.GetDecoder();
+
+    private readonly Decoder _inputDecoder = Terminal.Encoding.GetDecoder();
+
+    private char[] _chars = [];
+
+    public AsciicastWriter()
+    {
+        _json = new(
+            _buffer,
+            new()
+            {
+                // The default encoder escapes all non-ASCII characters, which needlessly bloats recordings. Control
+                // characters are still escaped.
+                Encoder = JavaScriptEncoder.UnsafeRelaxedJsonEscaping,
+            });
+    }
+
+    public void WriteHeader(Size size, DateTimeOffset timestamp)
+    {
+        _json.WriteStartObject();
+        _json.WriteNumber("version", 2);
+        _json.WriteNumber("width", size.Width);
+        _json.WriteNumber("height", size.Height);
+        _json.WriteNumber("timestamp", timestamp.ToUnixTimeSeconds());
+
+        if (Environment.GetEnvironmentVariable("TERM") is string term)
+        {
+            _json.WriteStartObject("env");
+            _json.WriteString("TERM", term);
+            _json.WriteEndObject();
+        }
+
+        _json.WriteEndObject();
+
+        EndLine();
+    }
+
+    public void WriteEvent(TimeSpan time, TerminalRecordingEventKind kind, scoped ReadOnlySpan<byte> data, Size size)
+    {
+        _json.WriteStartArray();
+        _json.WriteNumberValue(decimal.Round((decimal)time.Ticks / TimeSpan.TicksPerSecond, 6));
+
+        switch (kind)
+        {
+            case TerminalRecordingEventKind.Output:
+                _json.WriteStringValue("o");
+                WriteText(_outputDecoder, data);
+                break;
+            case TerminalRecordingEventKind.Input:
+                _json.WriteStringValue("i");
+                WriteText(_inputDecoder, data);
+                break;
+            case TerminalRecordingEventKind.Resize:
+                _json.WriteStringValue("r");
+                _json.WriteStringValue(
+                    string.Create(CultureInfo.InvariantCulture, $"{size.Width}x{size.Height}"));
+                break;
+            case TerminalRecordingEventKind.Marker:
+                _json.WriteStringValue("m");
+                _json.WriteStringValue(Terminal.Encoding.GetString(data));
+                break;
+        }
+
+        _json.WriteEndArray();
+
+        EndLine();
+    }
+
+    public void Flush(Stream stream)
+    {
+        stream.Write(_buffer.WrittenSpan);
+
+        _buffer.ResetWrittenCount();
+    }
+
+    private void WriteText(Decoder decoder, scoped ReadOnlySpan<byte> data)
+    {
+        var count = decoder.GetCharCount(data, flush: false);
+
+        if (_chars.Length < count)
+            _chars = new char[int.Max(count, _chars.Length * 2)];
+
+        _ = decoder.GetChars(data, _chars, flush: false);
+
+        _json.WriteStringValue(_chars.AsSpan(..count));
+    }
+
+    private void EndLine()
+    {
+        _json.Flush();
+        _json.Reset();
+
+        _buffer.Write("\n"u8);
+    }
+}
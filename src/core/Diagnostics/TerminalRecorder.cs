@@ -0,0 +1,536 @@
+// SPDX-License-Identifier: 0BSD
+
+namespace Vezel.Cathode.Diagnostics;
+
+[SuppressMessage("", "CA2213")]
+public sealed class TerminalRecorder : IDisposable
+{
+    private struct Slot
+    {
+        public long Sequence;
+
+        public long Timestamp;
+
+        public TerminalRecordingEventKind Kind;
+
+        public byte[]? Buffer;
+
+        public int Length;
+
+        public Size Size;
+    }
+
+    public const int DefaultMemoryLimit = 16 * 1024 * 1024;
+
+    // The ring only holds events until the writer thread gets to them, so this just needs to be large enough to absorb
+    // bursts of small writes. It must be a power of two.
+    private const int SlotCount = 4096;
+
+    // The writer thread polls for new events every 10 ms, and goes to sleep after 100 ms without any.
+    private const int PollInterval = 10;
+
+    private const int IdlePollCount = 10;
+
+    // In-memory recordings carve event data out of blocks of this size rather than allocating an array per event.
+    private const int BlockSize = 64 * 1024;
+
+    private static readonly TimeSpan _coalesceWindow = TimeSpan.FromMilliseconds(1);
+
+    public VirtualTerminal Terminal { get; }
+
+    public TerminalRecorderDropPolicy DropPolicy { get; }
+
+    public int MemoryLimit { get; }
+
+    public bool IsRecording => !_discarding;
+
+    public long DroppedEvents => Interlocked.Read(ref _dropped);
+
+    public TerminalRecording Recording =>
+        _recording ?? throw new InvalidOperationException("The recording is not in memory or is not finished.");
+
+    private readonly Lock _lock = new();
+
+    private readonly Slot[] _slots = new Slot[SlotCount];
+
+    private readonly Stream? _stream;
+
+    private readonly ImmutableArray<TerminalRecordingEvent>.Builder? _events;
+
+    private readonly bool _recordInput;
+
+    private readonly long _start;
+
+    private readonly DateTimeOffset _timestamp;
+
+    private readonly Size _size;
+
+    private readonly Thread _thread;
+
+    private readonly ManualResetEventSlim _signal = new();
+
+    private readonly ReadOnlySpanAction<byte, TerminalWriter> _outputWritten;
+
+    private readonly SpanAction<byte, TerminalReader> _inputRead;
+
+    private readonly Action<Size> _resized;
+
+    // Only accessed by the writer thread, along with the other _coalesced* fields.
+    private readonly ArrayBufferWriter<byte> _coalesced = new();
+
+    // Only accessed by the writer thread.
+    private byte[] _block = [];
+
+    private int _blockUsed;
+
+    private long _tail;
+
+    private long _head;
+
+    private long _buffered;
+
+    private long _dropped;
+
+    private int _sleeping;
+
+    private volatile bool _discarding;
+
+    private volatile bool _stopping;
+
+    private bool _stopped;
+
+    private Exception? _exception;
+
+    private TerminalRecording? _recording;
+
+    private TerminalRecordingEventKind _coalescedKind;
+
+    private TimeSpan _coalescedTime;
+
+    public TerminalRecorder(Stream? stream)
+        : this(Cathode.Terminal.System, stream)
+    {
+    }
+
+    public TerminalRecorder(VirtualTerminal terminal, Stream? stream)
+        : this(terminal, stream, TerminalRecorderDropPolicy.DropEvents, DefaultMemoryLimit, recordInput: false)
+    {
+    }
+
+    public TerminalRecorder(
+        VirtualTerminal terminal,
+        Stream? stream,
+        TerminalRecorderDropPolicy dropPolicy,
+        int memoryLimit,
+        bool recordInput)
+    {
+        Check.Null(terminal);
+        Check.Argument(stream?.CanWrite ?? true, stream);
+        Check.Enum(dropPolicy);
+        Check.Range(memoryLimit > 0, memoryLimit);
+
+        Terminal = terminal;
+        DropPolicy = dropPolicy;
+        MemoryLimit = memoryLimit;
+
+        // Without a stream, events are kept in memory so that they can be replayed later, e.g. in performance tests.
+        // The memory limit then covers the recording itself too, and recording stops once it is used up.
+        _stream = stream;
+        _events = stream == null ? ImmutableArray.CreateBuilder<TerminalRecordingEvent>() : null;
+        _recordInput = recordInput;
+
+        for (var i = 0; i < _slots.Length; i++)
+            _slots[i].Sequence = i;
+
+        _outputWritten = (buffer, _) => Enqueue(TerminalRecordingEventKind.Output, buffer, default);
+        _inputRead = (buffer, _) => Enqueue(TerminalRecordingEventKind.Input, buffer, default);
+        _resized = size => Enqueue(TerminalRecordingEventKind.Resize, [], size);
+
+        _timestamp = DateTimeOffset.UtcNow;
+        _start = Stopwatch.GetTimestamp();
+
+        try
+        {
+            _size = terminal.Size;
+        }
+        catch (TerminalNotAttachedException)
+        {
+            // Output is still worth recording when it is redirected; players need some size, so use the classic one.
+            _size = new(80, 24);
+        }
+
+        _thread = new(Run)
+        {
+            Name = "Terminal Recorder Writer",
+            IsBackground = true,
+        };
+
+        _thread.Start();
+
+        terminal.StandardOut.OutputWritten += _outputWritten;
+        terminal.StandardError.OutputWritten += _outputWritten;
+        terminal.TerminalOut.OutputWritten += _outputWritten;
+
+        if (recordInput)
+        {
+            terminal.StandardIn.InputRead += _inputRead;
+            terminal.TerminalIn.InputRead += _inputRead;
+        }
+
+        terminal.Resized += _resized;
+    }
+
+    public void Dispose()
+    {
+        // Disposal must not throw, so errors are only reported by Stop().
+        _ = StopCore();
+    }
+
+    public void Stop()
+    {
+        if (StopCore() is { } exception)
+            throw new IOException("Failed to write terminal recording.", exception);
+    }
+
+    public void AddMarker(string label)
+    {
+        Check.Null(label);
+
+        Enqueue(TerminalRecordingEventKind.Marker, Cathode.Terminal.Encoding.GetBytes(label), default);
+    }
+
+    private Exception? StopCore()
+    {
+        lock (_lock)
+        {
+            if (_stopped)
+                return _exception;
+
+            Terminal.StandardOut.OutputWritten -= _outputWritten;
+            Terminal.StandardError.OutputWritten -= _outputWritten;
+            Terminal.TerminalOut.OutputWritten -= _outputWritten;
+
+            if (_recordInput)
+            {
+                Terminal.StandardIn.InputRead -= _inputRead;
+                Terminal.TerminalIn.InputRead -= _inputRead;
+            }
+
+            Terminal.Resized -= _resized;
+
+            // A handler that is running concurrently with this may still get its event into the ring before the writer
+            // thread exits, but there are no guarantees; the recording ends at some point while we are stopping.
+            _discarding = true;
+            _stopping = true;
+
+            // Note that we do not dispose the event since a concurrent handler could still try to set it. It does not
+            // hold any native resources unless its wait handle is used anyway.
+            _signal.Set();
+            _thread.Join();
+
+            _stopped = true;
+
+            return _exception;
+        }
+    }
+
+    private void Enqueue(TerminalRecordingEventKind kind, scoped ReadOnlySpan<byte> data, Size size)
+    {
+        // This runs synchronously in the read/write path of the terminal, so it must be cheap and must never block.
+        // The data is copied into a pooled buffer and handed to the writer thread through a lock-free ring.
+        if (_discarding || (data.IsEmpty && kind != TerminalRecordingEventKind.Resize))
+            return;
+
+        var timestamp = Stopwatch.GetTimestamp();
+        var buffer = default(byte[]);
+
+        if (!data.IsEmpty)
+        {
+            buffer = ArrayPool<byte>.Shared.Rent(data.Length);
+
+            // The pool may hand out a much larger array than we asked for, and that is what we actually hold on to.
+            if (Interlocked.Add(ref _buffered, buffer.Length) > MemoryLimit)
+            {
+                Release(buffer);
+                Drop();
+
+                return;
+            }
+
+            data.CopyTo(buffer);
+        }
+
+        // This is the multi-producer side of Dmitry Vyukov's bounded queue; the sequence number of each slot tells us
+        // whether it is free for the position we are trying to claim.
+        var position = Volatile.Read(ref _tail);
+
+        while (true)
+        {
+            var difference = Volatile.Read(ref _slots[position & (SlotCount - 1)].Sequence) - position;
+
+            if (difference == 0)
+            {
+                if (Interlocked.CompareExchange(ref _tail, position + 1, position) == position)
+                    break;
+            }
+            else if (difference < 0)
+            {
+                // The ring is full; the writer thread is not keeping up.
+                if (buffer != null)
+                    Release(buffer);
+
+                Drop();
+
+                return;
+            }
+            else
+                position = Volatile.Read(ref _tail);
+        }
+
+        ref var slot = ref _slots[position & (SlotCount - 1)];
+
+        slot.Timestamp = timestamp;
+        slot.Kind = kind;
+        slot.Buffer = buffer;
+        slot.Length = data.Length;
+        slot.Size = size;
+
+        Volatile.Write(ref slot.Sequence, position + 1);
+
+        // Waking up the writer thread is expensive, so only do it if it has gone to sleep, or to nudge it when it is
+        // polling and the ring is filling up. The barrier orders the publication above with the read below, which the
+        // writer thread relies on.
+        Interlocked.MemoryBarrier();
+
+        if ((Volatile.Read(ref _sleeping) != 0 && Interlocked.Exchange(ref _sleeping, 0) != 0) ||
+            (position & (SlotCount / 4 - 1)) == 0)
+            _signal.Set();
+    }
+
+    private void Release(byte[] buffer)
+    {
+        _ = Interlocked.Add(ref _buffered, -buffer.Length);
+
+        ArrayPool<byte>.Shared.Return(buffer);
+    }
+
+    private void Drop()
+    {
+        _ = Interlocked.Increment(ref _dropped);
+
+        // A recording with a gap in it may not replay correctly, so the user can choose to end it at the first gap.
+        if (DropPolicy == TerminalRecorderDropPolicy.StopRecording)
+            _discarding = true;
+    }
+
+    [SuppressMessage("", "CA1031")]
+    private void Run()
+    {
+        var writer = _stream != null ? new AsciicastWriter() : null;
+        var reported = 0L;
+        var last = TimeSpan.Zero;
+        var idle = 0;
+
+        try
+        {
+            writer?.WriteHeader(_size, _timestamp);
+
+            while (true)
+            {
+                while (TryDequeue(out var slot))
+                {
+                    idle = 0;
+
+                    // Events from different threads can be published slightly out of order relative to their
+                    // timestamps; the format requires time to never go backwards.
+                    var time = Stopwatch.GetElapsedTime(_start, slot.Timestamp);
+
+                    if (time > last)
+                        last = time;
+
+                    // Dropped events are made visible at the point where we notice them, which is as close as we can
+                    // get to where they actually happened.
+                    var dropped = Interlocked.Read(ref _dropped);
+
+                    if (dropped != reported)
+                    {
+                        Commit(writer);
+
+                        var marker = string.Create(
+                            CultureInfo.InvariantCulture, $"Dropped {dropped - reported} events");
+
+                        Write(
+                            writer,
+                            last,
+                            TerminalRecordingEventKind.Marker,
+                            Cathode.Terminal.Encoding.GetBytes(marker),
+                            default);
+
+                        reported = dropped;
+                    }
+
+                    var buffer = slot.Buffer;
+
+                    Coalesce(writer, last, slot.Kind, buffer.AsSpan(..slot.Length), slot.Size);
+
+                    if (buffer != null)
+                        Release(buffer);
+                }
+
+                Commit(writer);
+
+                if (writer != null)
+                    writer.Flush(_stream!);
+
+                if (_stopping)
+                    break;
+
+                _signal.Reset();
+
+                // While events keep coming in, poll for them rather than making the producers wake us up for each one.
+                if (idle++ < IdlePollCount)
+                {
+                    _ = _signal.Wait(PollInterval);
+
+                    continue;
+                }
+
+                idle = 0;
+
+                // Announce that we are about to wait, then check the ring again so that an event published just before
+                // the announcement is not missed.
+                _ = Interlocked.Exchange(ref _sleeping, 1);
+
+                if (!IsEmpty() || _stopping)
+                {
+                    Volatile.Write(ref _sleeping, 0);
+
+                    continue;
+                }
+
+                _signal.Wait();
+            }
+
+            _stream?.Flush();
+
+            if (_events != null)
+                _recording = new(_size, _timestamp, _events.DrainToImmutable());
+        }
+        catch (Exception ex)
+        {
+            // There is nobody to report this to until Stop() is called, so just stop recording.
+            _exception = ex;
+            _discarding = true;
+
+            while (TryDequeue(out var slot))
+                if (slot.Buffer is { } buffer)
+                    Release(buffer);
+        }
+    }
+
+    private void Coalesce(
+        AsciicastWriter? writer, TimeSpan time, TerminalRecordingEventKind kind, ReadOnlySpan<byte> data, Size size)
+    {
+        // Programs often produce output in many small writes in quick succession. Merging these makes the recording
+        // smaller and cheaper to write, and the difference in timing is imperceptible during playback.
+        if (kind is not (TerminalRecordingEventKind.Output or TerminalRecordingEventKind.Input))
+        {
+            Commit(writer);
+            Write(writer, time, kind, data, size);
+
+            return;
+        }
+
+        if (_coalesced.WrittenCount != 0 && (kind != _coalescedKind || time - _coalescedTime >= _coalesceWindow))
+            Commit(writer);
+
+        if (_coalesced.WrittenCount == 0)
+        {
+            _coalescedKind = kind;
+            _coalescedTime = time;
+        }
+
+        _coalesced.Write(data);
+    }
+
+    private void Commit(AsciicastWriter? writer)
+    {
+        if (_coalesced.WrittenCount == 0)
+            return;
+
+        Write(writer, _coalescedTime, _coalescedKind, _coalesced.WrittenSpan, default);
+
+        _coalesced.ResetWrittenCount();
+    }
+
+    private void Write(
+        AsciicastWriter? writer, TimeSpan time, TerminalRecordingEventKind kind, ReadOnlySpan<byte> data, Size size)
+    {
+        if (writer != null)
+        {
+            writer.WriteEvent(time, kind, data, size);
+
+            if (writer.BufferedCount >= AsciicastWriter.FlushThreshold)
+                writer.Flush(_stream!);
+        }
+        else
+            Retain(time, kind, data, size);
+    }
+
+    private void Retain(TimeSpan time, TerminalRecordingEventKind kind, ReadOnlySpan<byte> data, Size size)
+    {
+        if (data.Length > _block.Length - _blockUsed)
+        {
+            var length = int.Max(data.Length, int.Min(BlockSize, MemoryLimit / 4));
+
+            // The recording never shrinks, so once its blocks use up the budget, nothing more can be recorded.
+            if (Interlocked.Add(ref _buffered, length) > MemoryLimit)
+            {
+                _ = Interlocked.Add(ref _buffered, -length);
+                _ = Interlocked.Increment(ref _dropped);
+
+                _discarding = true;
+
+                return;
+            }
+
+            _block = GC.AllocateUninitializedArray<byte>(length);
+            _blockUsed = 0;
+        }
+
+        var memory = _block.AsMemory(_blockUsed, data.Length);
+
+        data.CopyTo(memory.Span);
+
+        _blockUsed += data.Length;
+
+        _events!.Add(new(time, kind, memory, size));
+    }
+
+    private bool IsEmpty()
+    {
+        return Volatile.Read(ref _slots[_head & (SlotCount - 1)].Sequence) != _head + 1;
+    }
+
+    private bool TryDequeue(out Slot slot)
+    {
+        // The writer thread is the only consumer, so unlike the producer side, this needs no atomic operations.
+        ref var current = ref _slots[_head & (SlotCount - 1)];
+
+        if (Volatile.Read(ref current.Sequence) != _head + 1)
+        {
+            slot = default;
+
+            return false;
+        }
+
+        slot = current;
+        current.Buffer = null;
+
+        Volatile.Write(ref current.Sequence, _head + SlotCount);
+
+        _head++;
+
+        return true;
+    }
+}
@@ -0,0 +1,9 @@
+// SPDX-License-Identifier: 0BSD
+
+namespace Vezel.Cathode.Diagnostics;
+
+public enum TerminalRecorderDropPolicy
+{
+    DropEvents,
+    StopRecording,
+}
@@ -0,0 +1,180 @@
+// SPDX-License-Identifier: 0BSD
+
+using System.Text.Json;
+
+namespace Vezel.Cathode.Diagnostics;
+
+public sealed class TerminalRecording
+{
+    public Size Size { get; }
+
+    public DateTimeOffset Timestamp { get; }
+
+    public ImmutableArray<TerminalRecordingEvent> Events { get; }
+
+    internal TerminalRecording(Size size, DateTimeOffset timestamp, ImmutableArray<TerminalRecordingEvent> events)
+    {
+        Size = size;
+        Timestamp = timestamp;
+        Events = events;
+    }
+
+    public static TerminalRecording Load(Stream stream)
+    {
+        Check.Null(stream);
+
+        using var reader = new StreamReader(
+            stream, Terminal.Encoding, detectEncodingFromByteOrderMarks: false, leaveOpen: true);
+
+        var line = reader.ReadLine();
+
+        Validate(line != null);
+
+        Size size;
+        DateTimeOffset timestamp;
+
+        using (var header = JsonDocument.Parse(line))
+        {
+            var root = header.RootElement;
+
+            Validate(root.ValueKind == JsonValueKind.Object && GetInt64(root, "version") == 2);
+
+            var width = GetInt64(root, "width");
+            var height = GetInt64(root, "height");
+
+            Validate(width is > 0 and <= int.MaxValue && height is > 0 and <= int.MaxValue);
+
+            size = new((int)width, (int)height);
+            timestamp = GetInt64(root, "timestamp") is long time ? DateTimeOffset.FromUnixTimeSeconds(time) : default;
+        }
+
+        var events = ImmutableArray.CreateBuilder<TerminalRecordingEvent>();
+
+        while ((line = reader.ReadLine()) != null)
+        {
+            if (string.IsNullOrWhiteSpace(line))
+                continue;
+
+            using var document = JsonDocument.Parse(line);
+
+            var root = document.RootElement;
+
+            Validate(
+                root.ValueKind == JsonValueKind.Array &&
+                root.GetArrayLength() == 3 &&
+                root[0].ValueKind == JsonValueKind.Number &&
+                root[1].ValueKind == JsonValueKind.String &&
+                root[2].ValueKind == JsonValueKind.String);
+
+            var eventTime = TimeSpan.FromTicks((long)(root[0].GetDecimal() * TimeSpan.TicksPerSecond));
+            var data = root[2].GetString()!;
+            var eventSize = default(Size);
+
+            TerminalRecordingEventKind kind;
+
+            switch (root[1].GetString())
+            {
+                case "o":
+                    kind = TerminalRecordingEventKind.Output;
+                    break;
+                case "i":
+                    kind = TerminalRecordingEventKind.Input;
+                    break;
+                case "r":
+                    kind = TerminalRecordingEventKind.Resize;
+                    eventSize = ParseSize(data);
+                    data = string.Empty;
+                    break;
+                case "m":
+                    kind = TerminalRecordingEventKind.Marker;
+                    break;
+                default:
+                    // The format allows for event types to be added in the future.
+                    continue;
+            }
+
+            events.Add(new(eventTime, kind, Terminal.Encoding.GetBytes(data), eventSize));
+        }
+
+        return new(size, timestamp, events.DrainToImmutable());
+    }
+
+    public void Save(Stream stream)
+    {
+        Check.Null(stream);
+
+        var writer = new AsciicastWriter();
+
+        writer.WriteHeader(Size, Timestamp);
+
+        foreach (var evt in Events)
+        {
+            writer.WriteEvent(evt.Time, evt.Kind, evt.Data.Span, evt.Size);
+
+            if (writer.BufferedCount >= AsciicastWriter.FlushThreshold)
+                writer.Flush(stream);
+        }
+
+        writer.Flush(stream);
+    }
+
+    public async Task ReplayAsync(
+        TerminalWriter writer, double speed = 1, CancellationToken cancellationToken = default)
+    {
+        Check.Null(writer);
+        Check.Range(speed > 0, speed);
+
+        // An infinite speed replays the output as fast as the writer accepts it, which is useful for measuring how
+        // long it takes to render a real session.
+        var timed = !double.IsPositiveInfinity(speed);
+        var start = Stopwatch.GetTimestamp();
+
+        foreach (var evt in Events)
+        {
+            if (evt.Kind != TerminalRecordingEventKind.Output)
+                continue;
+
+            if (timed)
+            {
+                // Waiting for the absolute time of each event, rather than the gap between events, keeps delays from
+                // adding up over a long recording.
+                var delay = evt.Time / speed - Stopwatch.GetElapsedTime(start);
+
+                if (delay > TimeSpan.Zero)
+                    await Task.Delay(delay, cancellationToken).ConfigureAwait(false);
+            }
+
+            await writer.WriteAsync(evt.Data, cancellationToken).ConfigureAwait(false);
+        }
+    }
+
+    private static Size ParseSize(string value)
+    {
+        var separator = value.IndexOf('x', StringComparison.Ordinal);
+
+        Validate(separator != -1);
+
+        var valid = int.TryParse(value.AsSpan(..separator), CultureInfo.InvariantCulture, out var width);
+
+        valid &= int.TryParse(value.AsSpan((separator + 1)..), CultureInfo.InvariantCulture, out var height);
+
+        Validate(valid);
+
+        return new(width, height);
+    }
+
+    private static long? GetInt64(JsonElement element, string name)
+    {
+        return element.TryGetProperty(name, out var property) &&
+            property.ValueKind == JsonValueKind.Number &&
+            property.TryGetInt64(out var value)
+            ? value
+            : null;
+    }
+
+    private static void Validate([DoesNotReturnIf(false)] bool condition)
+    {
+        if (!condition)
+            throw new InvalidDataException("The recording is not in the asciicast v2 format.");
+    }
+}
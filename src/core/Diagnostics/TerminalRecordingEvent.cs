@@ -0,0 +1,23 @@
+// SPDX-License-Identifier: 0BSD
+
+namespace Vezel.Cathode.Diagnostics;
+
+public sealed class TerminalRecordingEvent
+{
+    public TimeSpan Time { get; }
+
+    public TerminalRecordingEventKind Kind { get; }
+
+    public ReadOnlyMemory<byte> Data { get; }
+
+    public Size Size { get; }
+
+    internal TerminalRecordingEvent(
+        TimeSpan time, TerminalRecordingEventKind kind, ReadOnlyMemory<byte> data, Size size)
+    {
+        Time = time;
+        Kind = kind;
+        Data = data;
+        Size = size;
+    }
+}
@@ -0,0 +1,11 @@
+// SPDX-License-Identifier: 0BSD
+
+namespace Vezel.Cathode.Diagnostics;
+
+public enum TerminalRecordingEventKind
+{
+    Output,
+    Input,
+    Resize,
+    Marker,
+}
@@ -0,0 +1,129 @@
+// SPDX-License-Identifier: 0BSD
+
+namespace Vezel.Cathode.IO;
+
+internal static class LineReader
+{
+    // Lines are terminated by \n, \r\n, or a lone \r, mirroring TextReader.ReadLine(). A yielded line refers directly
+    // to the buffers of the PipeReader and is only valid until the enumerator is advanced.
+    public static async IAsyncEnumerable<ReadOnlySequence<byte>> ReadLinesAsync(
+        PipeReader reader, int maxLength, [EnumeratorCancellation] CancellationToken cancellationToken)
+    {
+        // The number of bytes at the start of the buffer that are known to not contain a terminator. We track this so
+        // that a long line arriving in small chunks does not make us search the same bytes over and over again.
+        var scanned = 0L;
+
+        while (true)
+        {
+            var result = await reader.ReadAsync(cancellationToken).ConfigureAwait(false);
+            var buffer = result.Buffer;
+
+            try
+            {
+                while (TryReadLine(ref buffer, ref scanned, result.IsCompleted, maxLength, out var line))
+                    yield return line;
+            }
+            finally
+            {
+                // Consume the lines that have been yielded, but mark everything else as examined so that we wait for
+                // more data before looking at the remainder again. This also runs if the consumer stops early.
+                reader.AdvanceTo(buffer.Start, buffer.End);
+            }
+
+            if (result.IsCompleted || result.IsCanceled)
+                break;
+        }
+    }
+
+    private static bool TryReadLine(
+        ref ReadOnlySequence<byte> buffer,
+        ref long scanned,
+        bool completed,
+        int maxLength,
+        out ReadOnlySequence<byte> line)
+    {
+        // Only search as far as we need to; a line longer than the maximum length is split regardless of where its
+        // terminator is. Note that the window includes one byte past the maximum length since a terminator there still
+        // results in a line of exactly the maximum length.
+        var window = buffer.Length > maxLength ? buffer.Slice(0, maxLength + 1L) : buffer;
+        var position = scanned;
+        var terminator = -1L;
+        var value = (byte)0;
+
+        foreach (var segment in window.Slice(position))
+        {
+            var index = segment.Span.IndexOfAny((byte)'\n', (byte)'\r');
+
+            if (index != -1)
+            {
+                terminator = position + index;
+                value = segment.Span[index];
+
+                break;
+            }
+
+            position += segment.Length;
+        }
+
+        if (terminator != -1)
+        {
+            var length = 1L;
+
+            if (value == '\r')
+            {
+                // We cannot know whether this is \r\n or a lone \r until we see the next byte.
+                if (terminator + 1 == buffer.Length)
+                {
+                    if (!completed)
+                    {
+                        scanned = terminator;
+                        line = default;
+
+                        return false;
+                    }
+                }
+                else if (PeekByte(buffer.Slice(terminator + 1)) == '\n')
+                    length = 2;
+            }
+
+            line = buffer.Slice(0, terminator);
+            buffer = buffer.Slice(terminator + length);
+            scanned = 0;
+
+            return true;
+        }
+
+        if (window.Length > maxLength)
+        {
+            line = buffer.Slice(0, maxLength);
+            buffer = buffer.Slice(maxLength);
+            scanned = 0;
+
+            return true;
+        }
+
+        if (completed && !buffer.IsEmpty)
+        {
+            line = buffer;
+            buffer = buffer.Slice(buffer.End);
+            scanned = 0;
+
+            return true;
+        }
+
+        scanned = buffer.Length;
+        line = default;
+
+        return false;
+    }
+
+    private static byte PeekByte(ReadOnlySequence<byte> sequence)
+    {
+        // Slicing at a segment boundary can leave an empty first segment, so FirstSpan is not enough here.
+        foreach (var segment in sequence)
+            if (!segment.IsEmpty)
+                return segment.Span[0];
+
+        return 0;
+    }
+}
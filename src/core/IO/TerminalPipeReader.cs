@@ -0,0 +1,137 @@
+// SPDX-License-Identifier: 0BSD
+
+namespace Vezel.Cathode.IO;
+
+[SuppressMessage("", "CA1001")]
+internal sealed class TerminalPipeReader : PipeReader
+{
+    // These sizes are arbitrary and only affect performance.
+    private const int MinimumReadSize = 4096;
+
+    private const int MaximumReadSize = 1024 * 1024;
+
+    private readonly TerminalReader _reader;
+
+    // The pipe holds data that has been read but not yet consumed. We never block on the writer side of it; since we
+    // only read when the consumer asks for more data, the consumer is in control of how much gets buffered.
+    private readonly Pipe _pipe = new(
+        new(
+            readerScheduler: PipeScheduler.Inline,
+            writerScheduler: PipeScheduler.Inline,
+            pauseWriterThreshold: 0,
+            minimumSegmentSize: MinimumReadSize,
+            useSynchronizationContext: false));
+
+    private CancellationTokenSource _cancellation = new();
+
+    // Set while a terminal read is in progress so that CancelPendingRead() can interrupt it.
+    private CancellationTokenSource? _active;
+
+    private int _readSize = MinimumReadSize;
+
+    public TerminalPipeReader(TerminalReader reader)
+    {
+        _reader = reader;
+    }
+
+    [SuppressMessage("", "CA1031")]
+    public override async ValueTask<ReadResult> ReadAsync(CancellationToken cancellationToken = default)
+    {
+        var pending = _pipe.Reader.ReadAsync(cancellationToken);
+
+        // If the pipe already has data that the consumer has not examined, there is no need to touch the terminal.
+        if (!pending.IsCompleted)
+        {
+            var cancellation = _cancellation;
+
+            // The terminal read must be interrupted both when the caller's token is canceled and when the consumer
+            // calls CancelPendingRead().
+            using (cancellationToken.UnsafeRegister(
+                static state => Unsafe.As<CancellationTokenSource>(state!).Cancel(), cancellation))
+            {
+                Volatile.Write(ref _active, cancellation);
+
+                try
+                {
+                    await FillAsync(cancellation.Token).ConfigureAwait(false);
+                }
+                catch (OperationCanceledException)
+                {
+                    // The pending read will have been completed as either canceled or faulted.
+                }
+                catch (Exception ex)
+                {
+                    // Let the consumer observe the failure through the pipe.
+                    await _pipe.Writer.CompleteAsync(ex).ConfigureAwait(false);
+                }
+                finally
+                {
+                    Volatile.Write(ref _active, null);
+                }
+            }
+
+            if (!cancellation.TryReset())
+            {
+                cancellation.Dispose();
+
+                _cancellation = new();
+            }
+        }
+
+        return await pending.ConfigureAwait(false);
+    }
+
+    private async ValueTask FillAsync(CancellationToken cancellationToken)
+    {
+        var writer = _pipe.Writer;
+        var memory = writer.GetMemory(_readSize)[.._readSize];
+        var count = await _reader.FillPipeAsync(memory, cancellationToken).ConfigureAwait(false);
+
+        // EOF?
+        if (count == 0)
+        {
+            await writer.CompleteAsync().ConfigureAwait(false);
+
+            return;
+        }
+
+        // A read that fills the whole buffer suggests that more data is waiting (e.g. a peer sending large messages
+        // through a pipe), so try reading more at a time. Conversely, if reads start coming back mostly empty (e.g.
+        // interactive input), there is no point in tying up large buffers.
+        if (count == memory.Length)
+            _readSize = int.Min(_readSize * 2, MaximumReadSize);
+        else if (count < _readSize / 4)
+            _readSize = int.Max(_readSize / 2, MinimumReadSize);
+
+        writer.Advance(count);
+
+        _ = await writer.FlushAsync(CancellationToken.None).ConfigureAwait(false);
+    }
+
+    public override bool TryRead(out ReadResult result)
+    {
+        return _pipe.Reader.TryRead(out result);
+    }
+
+    public override void AdvanceTo(SequencePosition consumed)
+    {
+        _pipe.Reader.AdvanceTo(consumed);
+    }
+
+    public override void AdvanceTo(SequencePosition consumed, SequencePosition examined)
+    {
+        _pipe.Reader.AdvanceTo(consumed, examined);
+    }
+
+    public override void CancelPendingRead()
+    {
+        _pipe.Reader.CancelPendingRead();
+        Volatile.Read(ref _active)?.Cancel();
+    }
+
+    public override void Complete(Exception? exception = null)
+    {
+        _pipe.Reader.Complete(exception);
+        _pipe.Writer.Complete();
+    }
+}
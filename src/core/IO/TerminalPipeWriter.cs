@@ -0,0 +1,184 @@
+// SPDX-License-Identifier: 0BSD
+
+namespace Vezel.Cathode.IO;
+
+[SuppressMessage("", "CA1001")]
+internal sealed class TerminalPipeWriter : PipeWriter
+{
+    // This size is arbitrary and only affects performance.
+    private const int MinimumBufferSize = 4096;
+
+    public override bool CanGetUnflushedBytes => true;
+
+    public override long UnflushedBytes => _buffered;
+
+    private readonly TerminalWriter _writer;
+
+    private CancellationTokenSource _cancellation = new();
+
+    // Set while a terminal write is in progress so that CancelPendingFlush() can interrupt it.
+    private CancellationTokenSource? _active;
+
+    // Everything is buffered in a single array so that a flush results in as few writes to the terminal as possible,
+    // rather than one per segment.
+    private byte[] _buffer = [];
+
+    private int _buffered;
+
+    private bool _completed;
+
+    public TerminalPipeWriter(TerminalWriter writer)
+    {
+        _writer = writer;
+    }
+
+    public override Memory<byte> GetMemory(int sizeHint = 0)
+    {
+        Check.Range(sizeHint >= 0, sizeHint);
+
+        Reserve(sizeHint);
+
+        return _buffer.AsMemory(_buffered..);
+    }
+
+    public override Span<byte> GetSpan(int sizeHint = 0)
+    {
+        Check.Range(sizeHint >= 0, sizeHint);
+
+        Reserve(sizeHint);
+
+        return _buffer.AsSpan(_buffered..);
+    }
+
+    private void Reserve(int sizeHint)
+    {
+        Check.Operation(!_completed, $"The {nameof(PipeWriter)} has been completed.");
+
+        var available = _buffer.Length - _buffered;
+
+        if (available != 0 && available >= sizeHint)
+            return;
+
+        // Grow geometrically so that a producer writing lots of small messages between flushes does not cause lots of
+        // copying.
+        var buffer = ArrayPool<byte>.Shared.Rent(
+            int.Max(_buffered + int.Max(sizeHint, 1), int.Max(_buffer.Length * 2, MinimumBufferSize)));
+
+        _buffer.AsSpan(.._buffered).CopyTo(buffer);
+
+        Return();
+
+        _buffer = buffer;
+    }
+
+    public override void Advance(int bytes)
+    {
+        Check.Range(bytes >= 0 && bytes <= _buffer.Length - _buffered, bytes);
+
+        _buffered += bytes;
+    }
+
+    public override async ValueTask<FlushResult> FlushAsync(CancellationToken cancellationToken = default)
+    {
+        Check.Operation(!_completed, $"The {nameof(PipeWriter)} has been completed.");
+
+        if (_buffered == 0)
+            return new(isCanceled: false, isCompleted: false);
+
+        var cancellation = _cancellation;
+        var written = 0;
+        var canceled = false;
+
+        // The terminal write must be interrupted both when the caller's token is canceled and when the producer calls
+        // CancelPendingFlush().
+        using (cancellationToken.UnsafeRegister(
+            static state => Unsafe.As<CancellationTokenSource>(state!).Cancel(), cancellation))
+        {
+            Volatile.Write(ref _active, cancellation);
+
+            try
+            {
+                // The flush does not complete until the terminal has accepted all of the data. This is the only form
+                // of backpressure that makes sense here; there is nothing to gain from letting the producer run ahead.
+                written = await _writer.DrainPipeAsync(
+                    _buffer.AsMemory(.._buffered), cancellation.Token).ConfigureAwait(false);
+
+                // The data is only partially written if the flush was canceled.
+                canceled = written != _buffered;
+            }
+            catch (OperationCanceledException) when (cancellation.IsCancellationRequested)
+            {
+                canceled = true;
+            }
+            finally
+            {
+                Volatile.Write(ref _active, null);
+
+                // Keep whatever was not written so that a later flush can pick up where this one left off.
+                _buffer.AsSpan(written.._buffered).CopyTo(_buffer);
+
+                _buffered -= written;
+            }
+        }
+
+        if (!cancellation.TryReset())
+        {
+            cancellation.Dispose();
+
+            _cancellation = new();
+        }
+
+        if (canceled)
+            cancellationToken.ThrowIfCancellationRequested();
+
+        // Release a buffer that a burst of output made large once the output rate drops off, so that it is not held
+        // onto indefinitely.
+        if (_buffered == 0 && written < _buffer.Length / 4 && _buffer.Length > MinimumBufferSize)
+        {
+            Return();
+
+            _buffer = [];
+        }
+
+        return new(canceled, isCompleted: false);
+    }
+
+    public override void CancelPendingFlush()
+    {
+        Volatile.Read(ref _active)?.Cancel();
+    }
+
+    public override void Complete(Exception? exception = null)
+    {
+        if (_completed)
+            return;
+
+        _completed = true;
+
+        // Like the Stream-based PipeWriter, write out any remaining data unless the producer failed.
+        if (exception == null && _buffered != 0)
+            _writer.Write(_buffer.AsSpan(.._buffered));
+
+        Return();
+
+        _buffer = [];
+        _buffered = 0;
+    }
+
+    public override async ValueTask CompleteAsync(Exception? exception = null)
+    {
+        if (_completed)
+            return;
+
+        if (exception == null && _buffered != 0)
+            _ = await FlushAsync(CancellationToken.None).ConfigureAwait(false);
+
+        Complete(exception);
+    }
+
+    private void Return()
+    {
+        if (_buffer.Length != 0)
+            ArrayPool<byte>.Shared.Return(_buffer);
+    }
+}
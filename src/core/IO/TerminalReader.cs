@@ -8,6 +8,27 @@ public abstract class TerminalReader : TerminalHandle
 
     public abstract TextReader TextReader { get; }
 
+    private PipeReader? _lineReader;
+
+    private int _readingLines;
+
+    public PipeReader CreatePipeReader()
+    {
+        // Pipe readers are not thread-safe and cannot be reused once completed, so every consumer gets its own. Note
+        // that data that one reader has buffered is not visible to any other reader.
+        return new TerminalPipeReader(this);
+    }
+
+    private PipeReader CreateLineReader()
+    {
+        var reader = CreatePipeReader();
+
+        if (Interlocked.CompareExchange(ref _lineReader, reader, null) != null)
+            reader.Complete();
+
+        return _lineReader;
+    }
+
     protected abstract int ReadPartialCore(scoped Span<byte> buffer);
 
     protected abstract ValueTask<int> ReadPartialCoreAsync(Memory<byte> buffer, CancellationToken cancellationToken);
@@ -30,4 +51,52 @@ public abstract class TerminalReader : TerminalHandle
 
         return count;
     }
+
+    // Pipe readers go through this so that implementations can serve them more efficiently than ReadPartialAsync()
+    // would.
+    private protected virtual ValueTask<int> FillPipeCoreAsync(Memory<byte> buffer, CancellationToken cancellationToken)
+    {
+        return ReadPartialCoreAsync(buffer, cancellationToken);
+    }
+
+    [AsyncMethodBuilder(typeof(PoolingAsyncValueTaskMethodBuilder<>))]
+    internal async ValueTask<int> FillPipeAsync(Memory<byte> buffer, CancellationToken cancellationToken)
+    {
+        var count = await FillPipeCoreAsync(buffer, cancellationToken).ConfigureAwait(false);
+
+        InputRead?.Invoke(buffer.Span[..count], this);
+
+        return count;
+    }
+
+    public IAsyncEnumerable<ReadOnlySequence<byte>> ReadLinesAsync(
+        int maxLength = int.MaxValue, CancellationToken cancellationToken = default)
+    {
+        Check.Range(maxLength > 0, maxLength);
+
+        return ReadLinesCoreAsync(maxLength, cancellationToken);
+    }
+
+    private async IAsyncEnumerable<ReadOnlySequence<byte>> ReadLinesCoreAsync(
+        int maxLength, [EnumeratorCancellation] CancellationToken cancellationToken)
+    {
+        // All enumerations share a single pipe reader, which is not thread-safe, so only one may be in progress at a
+        // time. Enumerating again after a previous enumeration has finished is fine.
+        Check.Operation(
+            Interlocked.Exchange(ref _readingLines, 1) == 0,
+            $"Lines are already being read from this terminal handle.");
+
+        try
+        {
+            // The pipe is kept around so that data buffered past the last line is not lost when an enumeration stops
+            // early.
+            await foreach (var line in LineReader.ReadLinesAsync(
+                _lineReader ?? CreateLineReader(), maxLength, cancellationToken).ConfigureAwait(false))
+                yield return line;
+        }
+        finally
+        {
+            Volatile.Write(ref _readingLines, 0);
+        }
+    }
 }
@@ -1,13 +1,29 @@
 // SPDX-License-Identifier: 0BSD
 
+using Microsoft.Win32.SafeHandles;
+
 namespace Vezel.Cathode.IO;
 
 public abstract class TerminalWriter : TerminalHandle
 {
+    // This buffer size is arbitrary and only affects performance.
+    private const int TransferBufferSize = 1024 * 1024;
+
     public event ReadOnlySpanAction<byte, TerminalWriter>? OutputWritten;
 
     public abstract TextWriter TextWriter { get; }
 
+    // Implementations that move data without it passing through managed code cannot raise OutputWritten, so they need
+    // to know when to use the slow path.
+    private protected bool IsOutputObserved => OutputWritten != null;
+
+    public PipeWriter CreatePipeWriter()
+    {
+        // Pipe writers are not thread-safe and cannot be reused once completed, so every producer gets its own. Each
+        // one buffers independently; output from different writers is only interleaved at flush boundaries.
+        return new TerminalPipeWriter(this);
+    }
+
     protected abstract int WritePartialCore(scoped ReadOnlySpan<byte> buffer);
 
     protected abstract ValueTask<int> WritePartialCoreAsync(
@@ -32,4 +48,118 @@ public abstract class TerminalWriter : TerminalHandle
 
         return count;
     }
+
+    // Pipe writers go through this so that implementations can serve them more efficiently than WritePartialAsync()
+    // would. All of the data is written unless the operation is canceled, in which case the amount written so far is
+    // returned, if any.
+    private protected virtual async ValueTask<int> DrainPipeCoreAsync(
+        ReadOnlyMemory<byte> buffer, CancellationToken cancellationToken)
+    {
+        var written = 0;
+
+        try
+        {
+            while (written < buffer.Length)
+                written += await WritePartialCoreAsync(buffer[written..], cancellationToken).ConfigureAwait(false);
+        }
+        catch (OperationCanceledException) when (written != 0)
+        {
+            // The caller must know what was written so that it is not written again.
+        }
+
+        return written;
+    }
+
+    [AsyncMethodBuilder(typeof(PoolingAsyncValueTaskMethodBuilder<>))]
+    internal async ValueTask<int> DrainPipeAsync(ReadOnlyMemory<byte> buffer, CancellationToken cancellationToken)
+    {
+        var count = await DrainPipeCoreAsync(buffer, cancellationToken).ConfigureAwait(false);
+
+        OutputWritten?.Invoke(buffer.Span[..count], this);
+
+        return count;
+    }
+
+    protected virtual long WriteFromCore(SafeFileHandle handle, long offset, long count)
+    {
+        var array = ArrayPool<byte>.Shared.Rent((int)long.Min(count, TransferBufferSize));
+
+        try
+        {
+            var total = 0L;
+
+            while (total < count)
+            {
+                var read = RandomAccess.Read(
+                    handle, array.AsSpan(..(int)long.Min(count - total, array.Length)), offset + total);
+
+                if (read == 0)
+                    break;
+
+                this.Write(array.AsSpan(..read));
+
+                total += read;
+            }
+
+            return total;
+        }
+        finally
+        {
+            ArrayPool<byte>.Shared.Return(array);
+        }
+    }
+
+    protected virtual async ValueTask<long> WriteFromCoreAsync(
+        SafeFileHandle handle, long offset, long count, CancellationToken cancellationToken)
+    {
+        var array = ArrayPool<byte>.Shared.Rent((int)long.Min(count, TransferBufferSize));
+
+        try
+        {
+            var total = 0L;
+
+            while (total < count)
+            {
+                var read = await RandomAccess.ReadAsync(
+                    handle,
+                    array.AsMemory(..(int)long.Min(count - total, array.Length)),
+                    offset + total,
+                    cancellationToken).ConfigureAwait(false);
+
+                if (read == 0)
+                    break;
+
+                await this.WriteAsync(array.AsMemory(..read), cancellationToken).ConfigureAwait(false);
+
+                total += read;
+            }
+
+            return total;
+        }
+        finally
+        {
+            ArrayPool<byte>.Shared.Return(array);
+        }
+    }
+
+    public long WriteFrom(SafeFileHandle handle, long offset, long count)
+    {
+        Check.Null(handle);
+        Check.Argument(!handle.IsInvalid && !handle.IsClosed, handle);
+        Check.Range(offset >= 0, offset);
+        Check.Range(count >= 0, count);
+
+        return count != 0 ? WriteFromCore(handle, offset, count) : 0;
+    }
+
+    public ValueTask<long> WriteFromAsync(
+        SafeFileHandle handle, long offset, long count, CancellationToken cancellationToken = default)
+    {
+        Check.Null(handle);
+        Check.Argument(!handle.IsInvalid && !handle.IsClosed, handle);
+        Check.Range(offset >= 0, offset);
+        Check.Range(count >= 0, count);
+
+        return count != 0 ? WriteFromCoreAsync(handle, offset, count, cancellationToken) : ValueTask.FromResult(0L);
+    }
 }
@@ -9,6 +9,35 @@ internal static unsafe partial class TerminalInterop
     {
     }
 
+    [StructLayout(LayoutKind.Sequential)]
+    public struct TerminalProcess
+    {
+    }
+
+    [StructLayout(LayoutKind.Sequential)]
+    public struct TerminalProcessUsage
+    {
+        public long ElapsedTime;
+
+        public long UserTime;
+
+        public long SystemTime;
+
+        public long PeakMemory;
+
+        public long VoluntarySwitches;
+
+        public long InvoluntarySwitches;
+
+        public long BlockInputOperations;
+
+        public long BlockOutputOperations;
+
+        public long ReadOperations;
+
+        public long WriteOperations;
+    }
+
     public enum TerminalException
     {
         None,
@@ -154,6 +183,11 @@ internal static unsafe partial class TerminalInterop
     [UnmanagedCallConv(CallConvs = [typeof(CallConvCdecl)])]
     public static partial TerminalResult Write(TerminalDescriptor* descriptor, byte* buffer, int length, int* progress);
 
+    [LibraryImport(Library, EntryPoint = "cathode_transfer")]
+    [UnmanagedCallConv(CallConvs = [typeof(CallConvCdecl)])]
+    public static partial TerminalResult Transfer(
+        TerminalDescriptor* descriptor, int source, long offset, long length, long* progress);
+
     [LibraryImport(Library, EntryPoint = "cathode_poll")]
     [UnmanagedCallConv(CallConvs = [typeof(CallConvCdecl)])]
     public static partial void Poll([MarshalAs(UnmanagedType.U1)] bool write, int* fds, bool* results, int count);
@@ -161,4 +195,48 @@ internal static unsafe partial class TerminalInterop
     [LibraryImport(Library, EntryPoint = "cathode_cancel")]
     [UnmanagedCallConv(CallConvs = [typeof(CallConvCdecl)])]
     public static partial void Cancel(TerminalDescriptor* descriptor);
+
+    [LibraryImport(Library, EntryPoint = "cathode_spawn")]
+    [UnmanagedCallConv(CallConvs = [typeof(CallConvCdecl)])]
+    public static partial TerminalResult Spawn(
+        byte* path,
+        byte** arguments,
+        byte** environment,
+        byte* directory,
+        int @in,
+        int @out,
+        int err,
+        TerminalProcess** process,
+        int* id);
+
+    [LibraryImport(Library, EntryPoint = "cathode_spawn")]
+    [UnmanagedCallConv(CallConvs = [typeof(CallConvCdecl)])]
+    public static partial TerminalResult Spawn(
+        char* commandLine,
+        char* environment,
+        char* directory,
+        [MarshalAs(UnmanagedType.U1)] bool createWindow,
+        int show,
+        nint @in,
+        nint @out,
+        nint err,
+        TerminalProcess** process,
+        int* id);
+
+    [LibraryImport(Library, EntryPoint = "cathode_has_exited")]
+    [UnmanagedCallConv(CallConvs = [typeof(CallConvCdecl)])]
+    [return: MarshalAs(UnmanagedType.U1)]
+    public static partial bool HasExited(TerminalProcess* process);
+
+    [LibraryImport(Library, EntryPoint = "cathode_kill")]
+    [UnmanagedCallConv(CallConvs = [typeof(CallConvCdecl)])]
+    public static partial TerminalResult Kill(TerminalProcess* process);
+
+    [LibraryImport(Library, EntryPoint = "cathode_get_process_handle")]
+    [UnmanagedCallConv(CallConvs = [typeof(CallConvCdecl)])]
+    public static partial nint GetProcessHandle(TerminalProcess* process);
+
+    [LibraryImport(Library, EntryPoint = "cathode_reap")]
+    [UnmanagedCallConv(CallConvs = [typeof(CallConvCdecl)])]
+    public static partial TerminalResult Reap(TerminalProcess* process, int* code, TerminalProcessUsage* usage);
 }
@@ -1,5 +1,9 @@
 // SPDX-License-Identifier: 0BSD
 
+using System.Collections;
+
+using Vezel.Cathode.Native;
+
 namespace Vezel.Cathode.Processes;
 
 [SuppressMessage("", "CA1001")]
@@ -19,7 +23,11 @@ public sealed class ChildProcess
 
     public Task<int> Completion { get; }
 
-    private readonly Process _process;
+    public ChildProcessResourceUsage ResourceUsage =>
+        _usage ?? throw new InvalidOperationException(
+            "The process has not exited, or its resource usage could not be retrieved.");
+
+    private readonly Lock _lock = new();
 
     private readonly ChildProcessWriter? _in;
 
@@ -31,147 +39,383 @@ public sealed class ChildProcess
 
     private readonly TaskCompletionSource _exited = new(TaskCreationOptions.RunContinuationsAsynchronously);
 
-    [SuppressMessage("", "CA1031")]
-    internal ChildProcess(ChildProcessBuilder builder)
-    {
-        var (redirectIn, redirectOut, redirectError) =
-            (builder.RedirectStandardIn, builder.RedirectStandardOut, builder.RedirectStandardError);
+    private readonly bool _throwOnError;
 
-        var info = new ProcessStartInfo
-        {
-            FileName = builder.FileName,
-            WorkingDirectory = builder.WorkingDirectory,
-            CreateNoWindow = !builder.CreateWindow,
-            WindowStyle = builder.WindowStyle,
-            RedirectStandardInput = redirectIn,
-            RedirectStandardOutput = redirectOut,
-            RedirectStandardError = redirectError,
-        };
+    private readonly bool _terminal;
 
-        if (builder.JoinArguments)
-            info.Arguments = string.Join(" ", builder.Arguments);
-        else
-            foreach (var arg in builder.Arguments)
-                info.ArgumentList.Add(arg);
+    private readonly CancellationTokenRegistration _ctr;
 
-        foreach (var (name, value) in builder.Variables)
-            info.Environment.Add(name, value);
+    private unsafe TerminalInterop.TerminalProcess* _process;
 
-        // Setting the encodings without redirections causes exceptions.
-
-        if (redirectIn)
-            info.StandardInputEncoding = builder.StandardInEncoding;
-
-        if (redirectOut)
-            info.StandardOutputEncoding = builder.StandardOutEncoding;
-
-        if (redirectError)
-            info.StandardErrorEncoding = builder.StandardErrorEncoding;
-
-        _process = new Process
-        {
-            StartInfo = info,
-            EnableRaisingEvents = true,
-        };
-
-        var ctr = default(CancellationTokenRegistration);
-        var throwOnError = builder.ThrowOnError;
-        var terminal = !(redirectIn && redirectOut && redirectError);
-
-        _process.Exited += (_, _) =>
-        {
-            ctr.Dispose();
+    private volatile ChildProcessResourceUsage? _usage;
 
-            var code = _process.ExitCode;
+    [SuppressMessage("", "CA1031")]
+    [SuppressMessage("", "CA2000")]
+    internal unsafe ChildProcess(
+        ChildProcessBuilder builder, SafeHandle? standardIn = null, SafeHandle? standardOut = null)
+    {
+        // If we are given handles, the child process is part of a pipeline and is connected directly to its neighbors;
+        // we never see the data that flows between them.
+        var (redirectIn, redirectOut, redirectError) =
+            (standardIn == null && builder.RedirectStandardIn,
+             standardOut == null && builder.RedirectStandardOut,
+             builder.RedirectStandardError);
 
-            _ = throwOnError && code != 0
-                ? _completion.TrySetException(new ChildProcessErrorException($"Process exited with code {code}.", code))
-                : _completion.TrySetResult(code);
+        var inPipe = redirectIn ? new AnonymousPipeServerStream(PipeDirection.Out) : null;
+        var outPipe = redirectOut ? new AnonymousPipeServerStream(PipeDirection.In) : null;
+        var errorPipe = redirectError ? new AnonymousPipeServerStream(PipeDirection.In) : null;
 
-            if (terminal)
-                Terminal.System.ReapProcess(this);
+        var terminal = !((redirectIn || standardIn != null) && (redirectOut || standardOut != null) && redirectError);
 
-            _exited.SetResult();
-        };
+        var process = default(TerminalInterop.TerminalProcess*);
+        var id = 0;
 
         try
         {
+            var (inHandle, outHandle, errorHandle) =
+                (standardIn ?? inPipe?.ClientSafePipeHandle,
+                 standardOut ?? outPipe?.ClientSafePipeHandle,
+                 errorPipe?.ClientSafePipeHandle);
+
             // If the child process might use the terminal, start it under the raw mode lock since we only allow
             // starting non-redirected processes in cooked mode and we need to verify our current mode.
             if (terminal)
             {
                 Terminal.System.StartProcess(() =>
                 {
-                    _ = _process.Start();
+                    process = Spawn(builder, inHandle, outHandle, errorHandle, out id);
 
                     return this;
                 });
             }
             else
-                _ = _process.Start();
+                process = Spawn(builder, inHandle, outHandle, errorHandle, out id);
+        }
+        catch (Exception)
+        {
+            inPipe?.Dispose();
+            outPipe?.Dispose();
+            errorPipe?.Dispose();
+
+            throw;
         }
-        catch (Win32Exception ex)
+        finally
         {
-            throw new ChildProcessException("Failed to start child process.", ex);
+            // The child process has its own copies of these handles now. Closing ours ensures that the child sees EOF
+            // on its standard input when we close the pipe, and that we see EOF when the child exits.
+            inPipe?.DisposeLocalCopyOfClientHandle();
+            outPipe?.DisposeLocalCopyOfClientHandle();
+            errorPipe?.DisposeLocalCopyOfClientHandle();
         }
 
-        Id = _process.Id;
+        Id = id;
+        _throwOnError = builder.ThrowOnError;
+        _terminal = terminal;
+        _process = process;
 
-        if (redirectIn)
-            _in = new(_process.StandardInput);
+        if (inPipe != null)
+            _in = new(inPipe, builder.StandardInEncoding);
 
         var tasks = new List<Task>(2);
         var cancellationToken = builder.CancellationToken;
 
-        if (redirectOut)
+        if (outPipe != null)
             tasks.Add(
-                (_out = new(_process.StandardOutput, builder.StandardOutBufferSize, cancellationToken)).Completion);
+                (_out = new(
+                    outPipe,
+                    builder.StandardOutEncoding,
+                    builder.StandardOutBufferSize,
+                    cancellationToken)).Completion);
 
-        if (redirectError)
+        if (errorPipe != null)
             tasks.Add(
-                (_error = new(_process.StandardError, builder.StandardErrorBufferSize, cancellationToken)).Completion);
+                (_error = new(
+                    errorPipe,
+                    builder.StandardErrorEncoding,
+                    builder.StandardErrorBufferSize,
+                    cancellationToken)).Completion);
 
         // We register the cancellation callback here, after the process has started, so that we do not potentially kill
         // the process prior to or during startup.
-        ctr = cancellationToken.UnsafeRegister(
+        _ctr = cancellationToken.UnsafeRegister(
             static (@this, token) => Unsafe.As<ChildProcess>(@this!)._completion.TrySetCanceled(token), this);
 
-        Completion = Task.Run(async () =>
+        Completion = WaitForCompletionAsync(inPipe, tasks);
+
+        // This must come last since Reap() can be called immediately.
+        ChildProcessReaper.Register(this, process);
+    }
+
+    internal unsafe void Reap()
+    {
+        int code;
+        TerminalInterop.TerminalProcessUsage usage;
+        TerminalInterop.TerminalResult result;
+
+        // Kill() relies on the process ID not being reused while _process is set.
+        lock (_lock)
         {
-            int code;
+            result = TerminalInterop.Reap(_process, &code, &usage);
+
+            _process = null;
+        }
+
+        var reaped = result.Exception == TerminalInterop.TerminalException.None;
 
+        // This must be available by the time Completion finishes, whether successfully or not.
+        if (reaped)
+            _usage = new(usage);
+
+        _ctr.Dispose();
+
+        // If something else reaped the process (e.g. SIGCHLD is ignored), we have no idea how it exited, and must not
+        // pretend that it succeeded.
+        _ = !reaped
+            ? _completion.TrySetException(
+                new ChildProcessException(
+                    "Failed to retrieve child process exit status.", new Win32Exception(result.Error)))
+            : _throwOnError && code != 0
+                ? _completion.TrySetException(
+                    new ChildProcessErrorException($"Process exited with code {code}.", code))
+                : _completion.TrySetResult(code);
+
+        if (_terminal)
+            Terminal.System.ReapProcess(this);
+
+        _exited.SetResult();
+    }
+
+    [SuppressMessage("", "CA1031")]
+    private async Task<int> WaitForCompletionAsync(AnonymousPipeServerStream? inPipe, List<Task> tasks)
+    {
+        int code;
+
+        try
+        {
+            code = await _completion.Task.ConfigureAwait(false);
+        }
+        catch (OperationCanceledException)
+        {
             try
             {
-                code = await _completion.Task.ConfigureAwait(false);
+                KillCore(entireProcessTree: true);
             }
-            catch (OperationCanceledException)
+            catch (Exception)
             {
-                try
-                {
-                    _process.Kill(entireProcessTree: true);
-                }
-                catch (Exception)
-                {
-                    // Even if killing the process tree somehow fails, there is nothing we can do about it here.
-                }
+                // Even if killing the process tree somehow fails, there is nothing we can do about it here.
+            }
 
-                // Normally, _completion is completed from the Exited event handler. In the case of cancellation, we
-                // complete it from the cancellation callback. This means that we have to wait for the Exited event
-                // handler to run so that it becomes safe to dispose the process.
-                await _exited.Task.ConfigureAwait(false);
+            // Normally, _completion is completed from the waiter thread. In the case of cancellation, we complete it
+            // from the cancellation callback. This means that we have to wait for the waiter thread to finish so that
+            // it becomes safe to close the standard input pipe.
+            await _exited.Task.ConfigureAwait(false);
 
-                throw;
+            throw;
+        }
+        finally
+        {
+            // At this point, we know we are completely finished with the process. The readers close their pipes once
+            // they have drained them.
+            if (inPipe != null)
+                await inPipe.DisposeAsync().ConfigureAwait(false);
+        }
+
+        await Task.WhenAll(tasks).ConfigureAwait(false);
+
+        return code;
+    }
+
+    private static unsafe TerminalInterop.TerminalProcess* Spawn(
+        ChildProcessBuilder builder,
+        SafeHandle? standardIn,
+        SafeHandle? standardOut,
+        SafeHandle? standardError,
+        out int id)
+    {
+        var inAdded = false;
+        var outAdded = false;
+        var errorAdded = false;
+
+        // Make sure that the handles cannot be closed (and their values reused) while we pass them to the child.
+        try
+        {
+            standardIn?.DangerousAddRef(ref inAdded);
+            standardOut?.DangerousAddRef(ref outAdded);
+            standardError?.DangerousAddRef(ref errorAdded);
+
+            return SpawnCore(builder, standardIn, standardOut, standardError, out id);
+        }
+        finally
+        {
+            if (inAdded)
+                standardIn!.DangerousRelease();
+
+            if (outAdded)
+                standardOut!.DangerousRelease();
+
+            if (errorAdded)
+                standardError!.DangerousRelease();
+        }
+    }
+
+    private static unsafe TerminalInterop.TerminalProcess* SpawnCore(
+        ChildProcessBuilder builder,
+        SafeHandle? standardIn,
+        SafeHandle? standardOut,
+        SafeHandle? standardError,
+        out int id)
+    {
+        var environment =
+            new Dictionary<string, string>(
+                OperatingSystem.IsWindows() ? StringComparer.OrdinalIgnoreCase : StringComparer.Ordinal);
+
+        foreach (DictionaryEntry entry in Environment.GetEnvironmentVariables())
+            environment[(string)entry.Key] = (string)entry.Value!;
+
+        foreach (var (name, value) in builder.Variables)
+            environment[name] = value;
+
+        var directory = builder.WorkingDirectory.Length != 0 ? builder.WorkingDirectory : null;
+
+        TerminalInterop.TerminalResult result;
+        TerminalInterop.TerminalProcess* process;
+        int pid;
+
+        if (OperatingSystem.IsWindows())
+        {
+            // CreateProcessW may modify the command line buffer, so it cannot be a string.
+            var commandLine =
+                (ChildProcessCommandLine.Create(builder.FileName, builder.Arguments, builder.JoinArguments) + '\0')
+                .ToCharArray();
+
+            // The environment block is terminated by an empty entry; fixed adds the final null terminator.
+            var block = string.Concat(
+                environment
+                    .OrderBy(static kvp => kvp.Key, StringComparer.OrdinalIgnoreCase)
+                    .Select(static kvp => $"{kvp.Key}={kvp.Value}\0")
+                    .Append("\0"));
+
+            var show = builder.WindowStyle switch
+            {
+                ProcessWindowStyle.Hidden => 0, // SW_HIDE
+                ProcessWindowStyle.Minimized => 2, // SW_SHOWMINIMIZED
+                ProcessWindowStyle.Maximized => 3, // SW_SHOWMAXIMIZED
+                _ => -1,
+            };
+
+            fixed (char* commandLinePtr = commandLine)
+            fixed (char* blockPtr = block)
+            fixed (char* directoryPtr = directory)
+                result = TerminalInterop.Spawn(
+                    commandLinePtr,
+                    blockPtr,
+                    directoryPtr,
+                    builder.CreateWindow,
+                    show,
+                    standardIn?.DangerousGetHandle() ?? 0,
+                    standardOut?.DangerousGetHandle() ?? 0,
+                    standardError?.DangerousGetHandle() ?? 0,
+                    &process,
+                    &pid);
+        }
+        else
+        {
+            var arguments = builder.JoinArguments
+                ? ChildProcessCommandLine.Split(string.Join(' ', builder.Arguments))
+                : builder.Arguments;
+            var strings = new List<nint>(arguments.Length + environment.Count + 3);
+
+            byte* ToNative(string? value)
+            {
+                if (value == null)
+                    return null;
+
+                var ptr = Marshal.StringToCoTaskMemUTF8(value);
+
+                strings.Add(ptr);
+
+                return (byte*)ptr;
+            }
+
+            try
+            {
+                var argv = new nint[arguments.Length + 2];
+                var envp = new nint[environment.Count + 1];
+
+                argv[0] = (nint)ToNative(builder.FileName);
+
+                for (var i = 0; i < arguments.Length; i++)
+                    argv[i + 1] = (nint)ToNative(arguments[i]);
+
+                var j = 0;
+
+                foreach (var (name, value) in environment)
+                    envp[j++] = (nint)ToNative($"{name}={value}");
+
+                fixed (nint* argvPtr = argv)
+                fixed (nint* envpPtr = envp)
+                    result = TerminalInterop.Spawn(
+                        ToNative(ResolvePath(builder.FileName)),
+                        (byte**)argvPtr,
+                        (byte**)envpPtr,
+                        ToNative(directory),
+                        (int)(standardIn?.DangerousGetHandle() ?? -1),
+                        (int)(standardOut?.DangerousGetHandle() ?? -1),
+                        (int)(standardError?.DangerousGetHandle() ?? -1),
+                        &process,
+                        &pid);
             }
             finally
             {
-                // At this point, we know we are completely finished with the process.
-                _process.Dispose();
+                foreach (var ptr in strings)
+                    Marshal.FreeCoTaskMem(ptr);
             }
+        }
 
-            await Task.WhenAll(tasks).ConfigureAwait(false);
+        if (result.Exception != TerminalInterop.TerminalException.None)
+            throw new ChildProcessException("Failed to start child process.", new Win32Exception(result.Error));
 
-            return code;
-        });
+        id = pid;
+
+        return process;
+    }
+
+    [UnsupportedOSPlatform("windows")]
+    private static string ResolvePath(string fileName)
+    {
+        // This follows the search order of System.Diagnostics.Process, which in turn mimics that of CreateProcessW on
+        // Windows: the path as given if it is absolute, then relative to the directory of the current executable, then
+        // relative to the current directory, and finally each directory in PATH. Resolving relative paths here (rather
+        // than in the child) also matters because the child changes its working directory before executing the program.
+        if (Path.IsPathRooted(fileName))
+            return fileName;
+
+        if (Environment.ProcessPath is { } processPath && Path.GetDirectoryName(processPath) is { } processDirectory)
+        {
+            var path = Path.Combine(processDirectory, fileName);
+
+            if (File.Exists(path))
+                return path;
+        }
+
+        var currentPath = Path.Combine(Directory.GetCurrentDirectory(), fileName);
+
+        if (File.Exists(currentPath))
+            return currentPath;
+
+        foreach (var directory in (Environment.GetEnvironmentVariable("PATH") ?? string.Empty).Split(
+            ':', StringSplitOptions.RemoveEmptyEntries))
+        {
+            var path = Path.Combine(directory, fileName);
+
+            if (File.Exists(path) &&
+                (File.GetUnixFileMode(path) &
+                 (UnixFileMode.UserExecute | UnixFileMode.GroupExecute | UnixFileMode.OtherExecute)) != 0)
+                return Path.GetFullPath(path);
+        }
+
+        // Let the native driver report the appropriate error.
+        return fileName;
     }
 
     public static ChildProcess Run(string fileName, params ReadOnlySpan<string> arguments)
@@ -201,38 +445,67 @@ public sealed class ChildProcess
             .Run();
     }
 
-    [SuppressMessage("", "CA1031")]
     public void Kill(bool entireProcessTree = true)
     {
-        try
-        {
-            _process.Kill(entireProcessTree);
-        }
-        catch (Win32Exception ex)
-        {
-            throw new ChildProcessException("Failed to kill child process.", ex);
-        }
-        catch (AggregateException ex)
-        {
-            // This just contains a collection of Win32Exception for each failed process.
-            throw new ChildProcessException("Failed to kill child processes.", ex);
-        }
-        catch (InvalidOperationException)
+        // Like Process.Kill() followed by Process.WaitForExit(), this blocks the calling thread until the process has
+        // actually exited and been reaped, so that ResourceUsage is available once we return (Completion may still be
+        // draining redirected output). Use ChildProcessBuilder.WithCancellationToken() to kill without blocking.
+        KillCore(entireProcessTree);
+
+        _exited.Task.Wait();
+    }
+
+    private unsafe void KillCore(bool entireProcessTree)
+    {
+        // Finding the descendants of the process is expensive and has to go through System.Diagnostics.Process, so look
+        // the process up before taking the lock. This is safe because we check below, under the lock, that the process
+        // has not been reaped, i.e. that the ID has referred to our process all along.
+        using var tree = entireProcessTree ? GetProcess(Id) : null;
+
+        lock (_lock)
         {
-            // The process is already gone.
+            // The process has already exited and been reaped, so its ID may now refer to an unrelated process.
+            if (_process == null)
+                return;
+
+            try
+            {
+                // Descendants can only be found while the process is still running since they are reparented once it
+                // exits, so this has to happen before we kill the process itself.
+                tree?.Kill(entireProcessTree: true);
+            }
+            catch (Win32Exception ex)
+            {
+                throw new ChildProcessException("Failed to kill child process.", ex);
+            }
+            catch (AggregateException ex)
+            {
+                // This just contains a collection of Win32Exception for each failed process.
+                throw new ChildProcessException("Failed to kill child processes.", ex);
+            }
+            catch (InvalidOperationException)
+            {
+                // The process is already gone.
+            }
+
+            // The process ID remains valid until we reap the process, which cannot happen while we hold the lock.
+            var result = TerminalInterop.Kill(_process);
+
+            if (result.Exception != TerminalInterop.TerminalException.None)
+                throw new ChildProcessException("Failed to kill child process.", new Win32Exception(result.Error));
         }
+    }
 
+    private static Process? GetProcess(int id)
+    {
         try
         {
-            _process.WaitForExit();
+            return Process.GetProcessById(id);
         }
-        catch (SystemException)
+        catch (ArgumentException)
         {
-            // This method can theoretically throw a wide array of exceptions on Windows because of an internal call to
-            // Marshal.ThrowExceptionForHR() after a Win32 DuplicateHandle() call.
-            //
-            // The documentation also states separately that Win32Exception is a possibility, but it is unclear where
-            // that would come from. (But it derives from SystemException anyway.)
+            // The process is already gone.
+            return null;
         }
     }
 }
@@ -396,6 +396,13 @@ public sealed class ChildProcessBuilder
         return builder;
     }
 
+    public ChildProcessPipelineBuilder PipeTo(ChildProcessBuilder builder)
+    {
+        Check.Null(builder);
+
+        return new ChildProcessPipelineBuilder().PipeTo(this).PipeTo(builder);
+    }
+
     public ChildProcess Run()
     {
         return new(this);
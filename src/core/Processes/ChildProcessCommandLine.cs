@@ -0,0 +1,139 @@
+// SPDX-License-Identifier: 0BSD
+
+namespace Vezel.Cathode.Processes;
+
+internal static class ChildProcessCommandLine
+{
+    // These methods implement the quoting and splitting rules that the Microsoft C runtime uses for argv, which is also
+    // what System.Diagnostics.Process implements for ProcessStartInfo.Arguments on all platforms.
+
+    public static string Create(string fileName, ImmutableArray<string> arguments, bool join)
+    {
+        var sb = new StringBuilder();
+
+        // The program name is parsed with simpler rules; backslashes are never escapes.
+        _ = fileName.AsSpan().IndexOfAny(' ', '\t') != -1
+            ? sb.Append('"').Append(fileName).Append('"')
+            : sb.Append(fileName);
+
+        if (join)
+        {
+            if (arguments.Length != 0)
+                _ = sb.Append(' ').AppendJoin(' ', arguments);
+
+            return sb.ToString();
+        }
+
+        foreach (var argument in arguments)
+        {
+            _ = sb.Append(' ');
+
+            Quote(sb, argument);
+        }
+
+        return sb.ToString();
+    }
+
+    public static ImmutableArray<string> Split(string arguments)
+    {
+        var builder = ImmutableArray.CreateBuilder<string>();
+        var sb = new StringBuilder();
+        var i = 0;
+
+        while (true)
+        {
+            while (i < arguments.Length && arguments[i] is ' ' or '\t')
+                i++;
+
+            if (i == arguments.Length)
+                break;
+
+            var quoted = false;
+
+            while (i < arguments.Length && (quoted || arguments[i] is not (' ' or '\t')))
+            {
+                var backslashes = 0;
+
+                while (i < arguments.Length && arguments[i] == '\\')
+                {
+                    i++;
+                    backslashes++;
+                }
+
+                if (backslashes != 0)
+                {
+                    // Pairs of backslashes before a double quote collapse, and an odd one out escapes the quote.
+                    if (i == arguments.Length || arguments[i] != '"')
+                        _ = sb.Append('\\', backslashes);
+                    else
+                    {
+                        _ = sb.Append('\\', backslashes / 2);
+
+                        if (backslashes % 2 != 0)
+                            _ = sb.Append(arguments[i++]);
+                    }
+
+                    continue;
+                }
+
+                if (arguments[i] != '"')
+                {
+                    _ = sb.Append(arguments[i++]);
+
+                    continue;
+                }
+
+                // Two consecutive double quotes within a quoted region produce a literal double quote.
+                if (quoted && i + 1 < arguments.Length && arguments[i + 1] == '"')
+                {
+                    _ = sb.Append('"');
+
+                    i++;
+                }
+                else
+                    quoted = !quoted;
+
+                i++;
+            }
+
+            builder.Add(sb.ToString());
+
+            _ = sb.Clear();
+        }
+
+        return builder.DrainToImmutable();
+    }
+
+    private static void Quote(StringBuilder sb, string argument)
+    {
+        if (argument.Length != 0 && argument.AsSpan().IndexOfAny(' ', '\t', '"') == -1)
+        {
+            _ = sb.Append(argument);
+
+            return;
+        }
+
+        _ = sb.Append('"');
+
+        for (var i = 0; i < argument.Length; i++)
+        {
+            var backslashes = 0;
+
+            while (i < argument.Length && argument[i] == '\\')
+            {
+                i++;
+                backslashes++;
+            }
+
+            // Backslashes are only special when they precede a double quote, including the closing one.
+            if (i == argument.Length)
+                _ = sb.Append('\\', backslashes * 2);
+            else if (argument[i] == '"')
+                _ = sb.Append('\\', backslashes * 2 + 1).Append('"');
+            else
+                _ = sb.Append('\\', backslashes).Append(argument[i]);
+        }
+
+        _ = sb.Append('"');
+    }
+}
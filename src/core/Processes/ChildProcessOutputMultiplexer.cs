@@ -0,0 +1,134 @@
+// SPDX-License-Identifier: 0BSD
+
+namespace Vezel.Cathode.Processes;
+
+internal sealed class ChildProcessOutputMultiplexer
+{
+    // Producers wait for the current write to the terminal to finish once this much output is either pending or being
+    // written, so that a chatty child process cannot make us buffer an unbounded amount of output when the terminal is
+    // slow.
+    private const int PendingLimit = 1024 * 1024;
+
+    private readonly TerminalWriter _writer;
+
+    private readonly Lock _lock = new();
+
+    private ArrayBufferWriter<byte> _pending = new();
+
+    private ArrayBufferWriter<byte> _flushing = new();
+
+    // Completed (or faulted) whenever a write to the terminal finishes.
+    private TaskCompletionSource _drained = new(TaskCreationOptions.RunContinuationsAsynchronously);
+
+    private bool _busy;
+
+    // Once a write to the terminal fails, all further writes fail the same way.
+    private Exception? _exception;
+
+    public ChildProcessOutputMultiplexer(TerminalWriter writer)
+    {
+        _writer = writer;
+    }
+
+    public Task WriteLineAsync(
+        scoped ReadOnlySpan<byte> prefix, scoped in ReadOnlySequence<byte> line, scoped ReadOnlySpan<byte> suffix)
+    {
+        var wait = default(Task);
+        var start = false;
+
+        lock (_lock)
+        {
+            if (_exception != null)
+                return Task.FromException(_exception);
+
+            // The whole line goes into the buffer at once, which is what makes lines from different child processes
+            // come out intact. The lock is only held for the copy, so contention is short even with many producers.
+            _pending.Write(prefix);
+
+            foreach (var segment in line)
+                _pending.Write(segment.Span);
+
+            _pending.Write(suffix);
+
+            // If the writer is already running, it will pick up our line once it is done with the current write, so
+            // lines that arrive while a write is in progress are batched together.
+            if (_busy)
+            {
+                if (_pending.WrittenCount + _flushing.WrittenCount >= PendingLimit)
+                    wait = _drained.Task;
+            }
+            else
+                _busy = start = true;
+        }
+
+        // The writer runs on its own rather than in the producer that happens to start it. Otherwise, that producer
+        // would be stuck writing everyone else's output, and its own child process would be blocked in the meantime.
+        if (start)
+            _ = Task.Run(FlushAsync);
+
+        return wait ?? Task.CompletedTask;
+    }
+
+    [SuppressMessage("", "CA1031")]
+    private async Task FlushAsync()
+    {
+        while (true)
+        {
+            ArrayBufferWriter<byte> batch;
+
+            lock (_lock)
+            {
+                if (_pending.WrittenCount == 0)
+                {
+                    _busy = false;
+
+                    return;
+                }
+
+                batch = _pending;
+                _pending = _flushing;
+                _flushing = batch;
+            }
+
+            Exception? exception = null;
+
+            try
+            {
+                await _writer.WriteAsync(batch.WrittenMemory).ConfigureAwait(false);
+            }
+            catch (Exception ex)
+            {
+                exception = ex;
+            }
+
+            TaskCompletionSource drained;
+
+            lock (_lock)
+            {
+                batch.ResetWrittenCount();
+
+                if (exception != null)
+                {
+                    // Nothing is written from here on, so there is no point in holding onto the pending output.
+                    _exception = exception;
+                    _busy = false;
+
+                    _pending.ResetWrittenCount();
+                }
+
+                drained = _drained;
+                _drained = new(TaskCreationOptions.RunContinuationsAsynchronously);
+            }
+
+            // Producers waiting for the write would otherwise hang forever.
+            if (exception != null)
+            {
+                drained.SetException(exception);
+
+                return;
+            }
+
+            drained.SetResult();
+        }
+    }
+}
@@ -0,0 +1,87 @@
+// SPDX-License-Identifier: 0BSD
+
+namespace Vezel.Cathode.Processes;
+
+public sealed class ChildProcessPipeline
+{
+    public ImmutableArray<ChildProcess> Processes { get; }
+
+    public ChildProcessWriter StandardIn => Processes[0].StandardIn;
+
+    public ChildProcessReader StandardOut => Processes[^1].StandardOut;
+
+    public ChildProcessReader StandardError => Processes[^1].StandardError;
+
+    public Task<int> Completion { get; }
+
+    [SuppressMessage("", "CA2000")]
+    internal ChildProcessPipeline(ChildProcessPipelineBuilder builder)
+    {
+        var builders = builder.Processes;
+        var processes = ImmutableArray.CreateBuilder<ChildProcess>(builders.Length);
+        var input = default(AnonymousPipeServerStream);
+
+        try
+        {
+            for (var i = 0; i < builders.Length; i++)
+            {
+                // Each process writes directly into a kernel pipe that the next process reads from, so the data never
+                // passes through us.
+                var output = i != builders.Length - 1 ? new AnonymousPipeServerStream(PipeDirection.In) : null;
+
+                try
+                {
+                    processes.Add(new(builders[i], input?.SafePipeHandle, output?.ClientSafePipeHandle));
+                }
+                catch (Exception)
+                {
+                    output?.Dispose();
+
+                    throw;
+                }
+                finally
+                {
+                    // Only the child processes should hold on to the pipe ends; otherwise, they will never see EOF.
+                    input?.Dispose();
+                    output?.DisposeLocalCopyOfClientHandle();
+                }
+
+                input = output;
+            }
+        }
+        catch (Exception)
+        {
+            // Processes early in the pipeline may be waiting for input from us, so they will not go away on their own.
+            foreach (var process in processes)
+            {
+                try
+                {
+                    process.Kill(entireProcessTree: true);
+                }
+                catch (ChildProcessException)
+                {
+                }
+            }
+
+            throw;
+        }
+
+        Processes = processes.MoveToImmutable();
+        Completion = WaitForCompletionAsync();
+    }
+
+    private async Task<int> WaitForCompletionAsync()
+    {
+        // Like a shell, the exit code of the last process determines the result of the pipeline. Processes configured
+        // with ChildProcessBuilder.ThrowOnError can still fail the pipeline, however.
+        var codes = await Task.WhenAll(Processes.Select(static process => process.Completion)).ConfigureAwait(false);
+
+        return codes[^1];
+    }
+
+    public void Kill(bool entireProcessTree = true)
+    {
+        foreach (var process in Processes)
+            process.Kill(entireProcessTree);
+    }
+}
@@ -0,0 +1,36 @@
+// SPDX-License-Identifier: 0BSD
+
+namespace Vezel.Cathode.Processes;
+
+public sealed class ChildProcessPipelineBuilder
+{
+    public ImmutableArray<ChildProcessBuilder> Processes { get; private set; } = [];
+
+    internal ChildProcessPipelineBuilder()
+    {
+    }
+
+    private ChildProcessPipelineBuilder Clone()
+    {
+        return new()
+        {
+            Processes = Processes,
+        };
+    }
+
+    public ChildProcessPipelineBuilder PipeTo(ChildProcessBuilder builder)
+    {
+        Check.Null(builder);
+
+        var pipeline = Clone();
+
+        pipeline.Processes = Processes.Add(builder);
+
+        return pipeline;
+    }
+
+    public ChildProcessPipeline Run()
+    {
+        return new(this);
+    }
+}
@@ -2,30 +2,60 @@
 
 namespace Vezel.Cathode.Processes;
 
+[SuppressMessage("", "CA1001")]
 public sealed class ChildProcessReader
 {
     // This buffer size is arbitrary and only affects performance.
     private const int ReadBufferSize = 4096;
 
-    public Stream Stream { get; }
+    private const int IdleState = 0;
+
+    private const int StreamState = 1;
+
+    private const int LinesState = 2;
+
+    // Stream, TextReader, and ReadLinesAsync() all consume the same buffered output, so they cannot be mixed; data
+    // buffered by one would never be seen by the others. Once Stream or TextReader has been accessed, ReadLinesAsync()
+    // throws, and vice versa while a line enumeration is in progress. Only one line enumeration may be in progress at a
+    // time, but a new one can be started once the previous one has finished.
+    public Stream Stream => UseStream(_stream);
 
     public Encoding Encoding { get; }
 
-    public TextReader TextReader { get; }
+    public TextReader TextReader => UseStream(_textReader);
+
+    public int MaxLineLength { get; }
 
     internal Task Completion { get; }
 
     private readonly Pipe _pipe;
 
-    internal ChildProcessReader(StreamReader reader, int bufferSize, CancellationToken cancellationToken)
+    private readonly Stream _stream;
+
+    private readonly TextReader _textReader;
+
+    private int _state;
+
+    internal ChildProcessReader(Stream stream, Encoding encoding, int bufferSize, CancellationToken cancellationToken)
     {
-        _pipe = new(new(pauseWriterThreshold: bufferSize, useSynchronizationContext: false));
-        Stream = new SynchronizedStream(_pipe.Reader.AsStream());
-        Encoding = reader.CurrentEncoding;
-        TextReader = new SynchronizedTextReader(
-            new StreamReader(Stream, Encoding, detectEncodingFromByteOrderMarks: false, ReadBufferSize));
+        // The default resume threshold is larger than most buffer sizes that users would pick, which would leave the
+        // pump paused forever once the buffer fills up.
+        _pipe = new(
+            new(
+                pauseWriterThreshold: bufferSize,
+                resumeWriterThreshold: (bufferSize + 1) / 2,
+                useSynchronizationContext: false));
+
+        // The pipe pauses the pump when the buffer is full and only resumes it once about half of the buffer is free.
+        // If an unterminated line could keep it above that mark, ReadLinesAsync() would wait for more data forever, so
+        // lines must be split well before that point.
+        MaxLineLength = bufferSize != 0 ? int.Max((bufferSize + 1) / 2 - 1, 1) : int.MaxValue;
+        _stream = new SynchronizedStream(_pipe.Reader.AsStream());
+        Encoding = encoding;
+        _textReader = new SynchronizedTextReader(
+            new StreamReader(_stream, Encoding, detectEncodingFromByteOrderMarks: false, ReadBufferSize));
 
-        var readStream = reader.BaseStream;
+        var readStream = stream;
         var writeStream = _pipe.Writer.AsStream();
 
         Completion = Task.Run(
@@ -55,6 +85,8 @@ public sealed class ChildProcessReader
                 {
                     ArrayPool<byte>.Shared.Return(array);
 
+                    await readStream.DisposeAsync().ConfigureAwait(false);
+
                     // Users of the Stream and TextReader properties might block forever if we do not signal completion
                     // on the write end of the pipe. We do not signal completion on the read end of the pipe since we
                     // want users to be able to read all buffered data after the process exits.
@@ -63,4 +95,44 @@ public sealed class ChildProcessReader
             },
             CancellationToken.None);
     }
+
+    private T UseStream<T>(T value)
+    {
+        // The stream can be read from at any point after it has been handed out, so there is no going back from here.
+        Check.Operation(
+            Interlocked.CompareExchange(ref _state, StreamState, IdleState) != LinesState,
+            $"Lines are currently being read from this reader.");
+
+        return value;
+    }
+
+    public IAsyncEnumerable<ReadOnlySequence<byte>> ReadLinesAsync(
+        int? maxLength = null, CancellationToken cancellationToken = default)
+    {
+        Check.Range(maxLength is null or > 0, maxLength);
+        Check.Argument(maxLength is null || maxLength <= MaxLineLength, maxLength);
+
+        return ReadLinesCoreAsync(maxLength ?? MaxLineLength, cancellationToken);
+    }
+
+    private async IAsyncEnumerable<ReadOnlySequence<byte>> ReadLinesCoreAsync(
+        int maxLength, [EnumeratorCancellation] CancellationToken cancellationToken)
+    {
+        var state = Interlocked.CompareExchange(ref _state, LinesState, IdleState);
+
+        Check.Operation(
+            state != StreamState, $"The {nameof(Stream)} or {nameof(TextReader)} of this reader is in use.");
+        Check.Operation(state != LinesState, $"Lines are already being read from this reader.");
+
+        try
+        {
+            await foreach (var line in LineReader.ReadLinesAsync(
+                _pipe.Reader, maxLength, cancellationToken).ConfigureAwait(false))
+                yield return line;
+        }
+        finally
+        {
+            Volatile.Write(ref _state, IdleState);
+        }
+    }
 }
@@ -0,0 +1,104 @@
+// SPDX-License-Identifier: 0BSD
+
+using Vezel.Cathode.Native;
+
+namespace Vezel.Cathode.Processes;
+
+internal static unsafe class ChildProcessReaper
+{
+    // Waiting for child processes must not take a thread per process, since the scheduler may run hundreds of them. On
+    // Unix, a single thread checks all of our child processes whenever SIGCHLD arrives. On Windows, the thread pool
+    // waits on the process handles, many of them per thread.
+
+    // No signal arrives if SIGCHLD is ignored (the kernel then reaps child processes by itself) or if some other code
+    // replaces the runtime's handler, so fall back to polling at this interval while there are processes to wait for.
+    private const int PollInterval = 1000;
+
+    private sealed class ProcessWaitHandle : WaitHandle
+    {
+        public ProcessWaitHandle(nint handle)
+        {
+            // The handle is owned by the native process object, which closes it when the process is reaped.
+            SafeWaitHandle = new(handle, ownsHandle: false);
+        }
+    }
+
+    private static readonly Lock _lock = new();
+
+    private static readonly Dictionary<ChildProcess, nint> _processes = [];
+
+    private static readonly AutoResetEvent _signal = new(initialState: false);
+
+    private static PosixSignalRegistration? _registration;
+
+    [SuppressMessage("", "CA2000")]
+    public static void Register(ChildProcess child, TerminalInterop.TerminalProcess* process)
+    {
+        if (OperatingSystem.IsWindows())
+        {
+            // Since the wait only fires once, it is removed from the thread pool without having to unregister it. The
+            // wait handle does not own anything, so there is no need to dispose it either.
+            _ = ThreadPool.UnsafeRegisterWaitForSingleObject(
+                new ProcessWaitHandle(TerminalInterop.GetProcessHandle(process)),
+                static (state, _) => Unsafe.As<ChildProcess>(state!).Reap(),
+                child,
+                Timeout.Infinite,
+                executeOnlyOnce: true);
+
+            return;
+        }
+
+        lock (_lock)
+        {
+            _processes.Add(child, (nint)process);
+
+            if (_registration == null)
+                Start();
+        }
+
+        // The process may have exited before we started tracking it, in which case its SIGCHLD was ignored.
+        _ = _signal.Set();
+    }
+
+    [UnsupportedOSPlatform("windows")]
+    private static void Start()
+    {
+        _registration = PosixSignalRegistration.Create(PosixSignal.SIGCHLD, static _ => _signal.Set());
+
+        new Thread(Run)
+        {
+            Name = "Child Process Reaper",
+            IsBackground = true,
+        }.Start();
+    }
+
+    private static void Run()
+    {
+        var exited = new List<ChildProcess>();
+        var waiting = false;
+
+        while (true)
+        {
+            _ = _signal.WaitOne(waiting ? PollInterval : Timeout.Infinite);
+
+            // SIGCHLD does not tell us which process exited, and multiple signals can coalesce into one, so check all
+            // of them. The processes are not reaped here, so checking does not interfere with anything else.
+            lock (_lock)
+            {
+                foreach (var (child, process) in _processes)
+                    if (TerminalInterop.HasExited((TerminalInterop.TerminalProcess*)process))
+                        exited.Add(child);
+
+                foreach (var child in exited)
+                    _ = _processes.Remove(child);
+
+                waiting = _processes.Count != 0;
+            }
+
+            foreach (var child in exited)
+                child.Reap();
+
+            exited.Clear();
+        }
+    }
+}
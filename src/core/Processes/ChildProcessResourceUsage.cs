@@ -0,0 +1,56 @@
+// SPDX-License-Identifier: 0BSD
+
+using Vezel.Cathode.Native;
+
+namespace Vezel.Cathode.Processes;
+
+public sealed class ChildProcessResourceUsage
+{
+    public TimeSpan ElapsedTime { get; }
+
+    public TimeSpan UserProcessorTime { get; }
+
+    public TimeSpan SystemProcessorTime { get; }
+
+    public TimeSpan TotalProcessorTime => UserProcessorTime + SystemProcessorTime;
+
+    public long PeakMemoryUsage { get; }
+
+    public long? VoluntaryContextSwitches { get; }
+
+    public long? InvoluntaryContextSwitches { get; }
+
+    // These count blocks transferred to and from storage, excluding anything served from the page cache. Unix only.
+    public long? BlockInputOperations { get; }
+
+    public long? BlockOutputOperations { get; }
+
+    // These count I/O calls of any kind (files, pipes, devices, etc), regardless of size. Windows only.
+    public long? ReadOperations { get; }
+
+    public long? WriteOperations { get; }
+
+    internal ChildProcessResourceUsage(in TerminalInterop.TerminalProcessUsage usage)
+    {
+        static TimeSpan ToTimeSpan(long nanoseconds)
+        {
+            return TimeSpan.FromTicks(nanoseconds / TimeSpan.NanosecondsPerTick);
+        }
+
+        static long? ToCounter(long value)
+        {
+            return value != -1 ? value : null;
+        }
+
+        ElapsedTime = ToTimeSpan(usage.ElapsedTime);
+        UserProcessorTime = ToTimeSpan(usage.UserTime);
+        SystemProcessorTime = ToTimeSpan(usage.SystemTime);
+        PeakMemoryUsage = usage.PeakMemory;
+        VoluntaryContextSwitches = ToCounter(usage.VoluntarySwitches);
+        InvoluntaryContextSwitches = ToCounter(usage.InvoluntarySwitches);
+        BlockInputOperations = ToCounter(usage.BlockInputOperations);
+        BlockOutputOperations = ToCounter(usage.BlockOutputOperations);
+        ReadOperations = ToCounter(usage.ReadOperations);
+        WriteOperations = ToCounter(usage.WriteOperations);
+    }
+}
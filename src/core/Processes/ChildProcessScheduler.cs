@@ -0,0 +1,272 @@
+// SPDX-License-Identifier: 0BSD
+
+using Vezel.Cathode.Text.Control;
+
+namespace Vezel.Cathode.Processes;
+
+public sealed class ChildProcessScheduler
+{
+    // This size is arbitrary and is only used for job output streams that the builder leaves unbounded.
+    private const int DefaultBufferSize = 256 * 1024;
+
+    private sealed class Job
+    {
+        public required ChildProcessBuilder Builder { get; init; }
+
+        public required byte[] Prefix { get; init; }
+
+        public required byte[] Suffix { get; init; }
+
+        public TaskCompletionSource<ChildProcess> Completion { get; } =
+            new(TaskCreationOptions.RunContinuationsAsynchronously);
+
+        public CancellationTokenRegistration Registration { get; set; }
+    }
+
+    public int MaxParallelism { get; }
+
+    public TerminalWriter Writer { get; }
+
+    // Changing this only affects jobs scheduled afterwards.
+    public ColorDepth ColorDepth
+    {
+        get
+        {
+            lock (_lock)
+                return _colorDepth;
+        }
+        set
+        {
+            Check.Enum(value);
+
+            lock (_lock)
+                _colorDepth = value;
+        }
+    }
+
+    // Higher priorities go first; jobs with equal priorities go in the order they were scheduled.
+    private static readonly Comparer<(int Priority, long Sequence)> _comparer =
+        Comparer<(int Priority, long Sequence)>.Create(
+            static (x, y) =>
+                x.Priority != y.Priority ? y.Priority.CompareTo(x.Priority) : x.Sequence.CompareTo(y.Sequence));
+
+    private readonly Lock _lock = new();
+
+    private readonly PriorityQueue<Job, (int Priority, long Sequence)> _queue = new(_comparer);
+
+    private readonly ChildProcessOutputMultiplexer _output;
+
+    private ColorDepth _colorDepth = ColorDepth.TrueColor;
+
+    private long _sequence;
+
+    private int _running;
+
+    public ChildProcessScheduler()
+        : this(Environment.ProcessorCount)
+    {
+    }
+
+    public ChildProcessScheduler(int maxParallelism)
+        : this(maxParallelism, Terminal.StandardOut)
+    {
+    }
+
+    public ChildProcessScheduler(int maxParallelism, TerminalWriter writer)
+    {
+        Check.Range(maxParallelism > 0, maxParallelism);
+        Check.Null(writer);
+
+        MaxParallelism = maxParallelism;
+        Writer = writer;
+        _output = new(writer);
+    }
+
+    public Task<ChildProcess> Schedule(
+        ChildProcessBuilder builder, string? prefix = null, Color? color = null, int priority = 0)
+    {
+        Check.Null(builder);
+        Check.Argument(color?.A is null or byte.MaxValue, color);
+
+        var cancellationToken = builder.CancellationToken;
+
+        if (cancellationToken.IsCancellationRequested)
+            return Task.FromCanceled<ChildProcess>(cancellationToken);
+
+        var (jobPrefix, jobSuffix) = CreateDecorations(prefix, color);
+        var job = new Job
+        {
+            Builder = builder,
+            Prefix = jobPrefix,
+            Suffix = jobSuffix,
+        };
+
+        // A job that is canceled while it is queued never takes up a slot; Dispatch() skips it.
+        job.Registration = cancellationToken.UnsafeRegister(
+            static (job, token) => Unsafe.As<Job>(job!).Completion.TrySetCanceled(token), job);
+
+        lock (_lock)
+            _queue.Enqueue(job, (priority, _sequence++));
+
+        Dispatch();
+
+        return job.Completion.Task;
+    }
+
+    private (byte[] Prefix, byte[] Suffix) CreateDecorations(string? prefix, Color? color)
+    {
+        var depth = ColorDepth;
+
+        // Escape sequences would only garble output that is redirected to a file or pipe.
+        var colored = color != null && depth != ColorDepth.None && Writer.IsInteractive;
+        var head = new ControlBuilder(capacity: 64)
+        {
+            ColorDepth = depth,
+        };
+        var tail = new ControlBuilder(capacity: 16);
+
+        if (colored)
+            _ = head.SetForegroundColor(color!.Value);
+
+        // With a prefix, only the prefix is colored. Without one, the whole line is.
+        if (!string.IsNullOrEmpty(prefix))
+        {
+            _ = head.Print(prefix);
+
+            if (colored)
+                _ = head.ResetAttributes();
+        }
+        else if (colored)
+            _ = tail.ResetAttributes();
+
+        _ = tail.PrintLine();
+
+        return (Encode(head.Span), Encode(tail.Span));
+    }
+
+    private static byte[] Encode(scoped ReadOnlySpan<char> value)
+    {
+        var encoding = Terminal.Encoding;
+        var bytes = new byte[encoding.GetByteCount(value)];
+
+        _ = encoding.GetBytes(value, bytes);
+
+        return bytes;
+    }
+
+    private void Dispatch()
+    {
+        while (true)
+        {
+            Job? job;
+
+            lock (_lock)
+            {
+                if (_running == MaxParallelism || !_queue.TryDequeue(out job, out _))
+                    return;
+
+                if (job.Completion.Task.IsCompleted)
+                    continue;
+
+                _running++;
+            }
+
+            // Starting a process is fairly expensive, so do not make the caller of Schedule() pay for it.
+            _ = Task.Run(() => RunAsync(job));
+        }
+    }
+
+    [SuppressMessage("", "CA1031")]
+    private async Task RunAsync(Job job)
+    {
+        try
+        {
+            // This waits for the cancellation callback if it is running, so the check below is reliable.
+            await job.Registration.DisposeAsync().ConfigureAwait(false);
+
+            if (job.Completion.Task.IsCompleted)
+                return;
+
+            var builder = job.Builder;
+            var cancellationToken = builder.CancellationToken;
+
+            ChildProcess process;
+
+            try
+            {
+                builder = builder.WithRedirections(true, true, true);
+
+                // With unbounded buffers, a child process that writes faster than the terminal can keep up with would
+                // never be blocked, and we would end up buffering all of its output.
+                if (builder.StandardOutBufferSize == 0 || builder.StandardErrorBufferSize == 0)
+                    builder = builder.WithBufferSizes(
+                        builder.StandardOutBufferSize != 0 ? builder.StandardOutBufferSize : DefaultBufferSize,
+                        builder.StandardErrorBufferSize != 0 ? builder.StandardErrorBufferSize : DefaultBufferSize);
+
+                process = builder.Run();
+            }
+            catch (Exception ex)
+            {
+                _ = job.Completion.TrySetException(ex);
+
+                return;
+            }
+
+            // The caller only gets hold of the process once it has exited, so nobody can ever write to its input. Close
+            // it right away so that a child reading it sees EOF rather than waiting forever. (Inheriting our standard
+            // input instead would have parallel jobs competing for it.)
+            await process.StandardIn.CloseAsync().ConfigureAwait(false);
+
+            try
+            {
+                await Task.WhenAll(
+                    PumpAsync(job, process.StandardOut, cancellationToken),
+                    PumpAsync(job, process.StandardError, cancellationToken)).ConfigureAwait(false);
+            }
+            catch (OperationCanceledException)
+            {
+                // The process is being killed due to cancellation; its completion reflects that.
+            }
+            catch (Exception ex)
+            {
+                // We failed to write to the terminal. The process would block forever once its pipes fill up.
+                try
+                {
+                    process.Kill();
+                }
+                catch (ChildProcessException)
+                {
+                    // The process may have exited on its own in the meantime.
+                }
+
+                _ = job.Completion.TrySetException(ex);
+
+                return;
+            }
+
+            try
+            {
+                _ = await process.Completion.ConfigureAwait(false);
+            }
+            catch (Exception)
+            {
+                // Whatever happened, the caller can see it through ChildProcess.Completion.
+            }
+
+            _ = job.Completion.TrySetResult(process);
+        }
+        finally
+        {
+            lock (_lock)
+                _running--;
+
+            Dispatch();
+        }
+    }
+
+    private async Task PumpAsync(Job job, ChildProcessReader reader, CancellationToken cancellationToken)
+    {
+        await foreach (var line in reader.ReadLinesAsync(cancellationToken: cancellationToken).ConfigureAwait(false))
+            await _output.WriteLineAsync(job.Prefix, line, job.Suffix).ConfigureAwait(false);
+    }
+}
@@ -13,13 +13,22 @@ public sealed class ChildProcessWriter
 
     public TextWriter TextWriter { get; }
 
-    internal ChildProcessWriter(StreamWriter writer)
+    private readonly Stream _stream;
+
+    internal ChildProcessWriter(Stream stream, Encoding encoding)
     {
-        Stream = new SynchronizedStream(writer.BaseStream);
-        Encoding = writer.Encoding;
+        _stream = stream;
+        Stream = new SynchronizedStream(stream);
+        Encoding = encoding;
         TextWriter = new SynchronizedTextWriter(new StreamWriter(Stream, Encoding, WriteBufferSize)
         {
             AutoFlush = true,
         });
     }
+
+    internal ValueTask CloseAsync()
+    {
+        // The child process sees EOF once the write end of the pipe is closed.
+        return _stream.DisposeAsync();
+    }
 }
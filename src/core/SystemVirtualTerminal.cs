@@ -1,6 +1,7 @@
 // SPDX-License-Identifier: 0BSD
 
 using Vezel.Cathode.Processes;
+using Vezel.Cathode.Terminals;
 
 namespace Vezel.Cathode;
 
@@ -15,9 +16,15 @@ public abstract class SystemVirtualTerminal : VirtualTerminal
             {
                 _resized += value;
 
-                if (_resized != null)
-                    _resizeEvent.Set();
+                if (_resized == null)
+                    return;
+
+                StartResizePoller();
+
+                _resizeEvent.Set();
             }
+
+            StartMonitoring();
         }
 
         remove
@@ -108,6 +115,8 @@ public abstract class SystemVirtualTerminal : VirtualTerminal
         {
             if (QuerySize() is { } s)
                 _size = s;
+            else if (_size == null)
+                RefreshSize();
 
             return _size ?? throw new TerminalNotAttachedException();
         }
@@ -125,12 +134,28 @@ public abstract class SystemVirtualTerminal : VirtualTerminal
         }
     }
 
+    public TimeSpan CapabilityProbeTimeout
+    {
+        get => _probeTimeout;
+        set
+        {
+            Check.Range(value > TimeSpan.Zero, value);
+
+            using (Control.Guard())
+                _probeTimeout = value;
+        }
+    }
+
     private readonly Lock _sizeLock = new();
 
     private readonly Lock _signalLock = new();
 
     private readonly Lock _rawLock = new();
 
+    private readonly Lock _initializeLock = new();
+
+    private readonly Lock _capabilitiesLock = new();
+
     private readonly ManualResetEventSlim _resizeEvent = new();
 
     private readonly HashSet<ChildProcess> _processes = [];
@@ -151,12 +176,23 @@ public abstract class SystemVirtualTerminal : VirtualTerminal
 
     private TimeSpan _sizeInterval = TimeSpan.FromMilliseconds(100);
 
-    private protected SystemVirtualTerminal()
+    private TimeSpan _probeTimeout = TimeSpan.FromMilliseconds(500);
+
+    private Thread? _resizePoller;
+
+    private volatile bool _initialized;
+
+    private TerminalCapabilities? _capabilities;
+
+    private void StartResizePoller()
     {
-        // Try to get the terminal size as early as reasonably possible.
+        if (_resizePoller != null)
+            return;
+
+        // Get the current size so that we have something to compare against when the size changes.
         RefreshSize();
 
-        var thread = new Thread(() =>
+        _resizePoller = new Thread(() =>
         {
             while (true)
             {
@@ -172,7 +208,11 @@ public abstract class SystemVirtualTerminal : VirtualTerminal
             IsBackground = true,
         };
 
-        thread.Start();
+        _resizePoller.Start();
+    }
+
+    private protected virtual void StartMonitoring()
+    {
     }
 
     private protected abstract Size? QuerySize();
@@ -211,6 +251,30 @@ public abstract class SystemVirtualTerminal : VirtualTerminal
             preferLocal: true);
     }
 
+    private protected abstract void Initialize();
+
+    internal void EnsureInitialized()
+    {
+        // Configuring the terminal is deferred until something actually needs it, so that programs that never interact
+        // with the terminal (e.g. because they are redirected) do not pay for it.
+        if (_initialized)
+            return;
+
+        // This is a separate lock from the raw mode lock since this method is reached from read/write paths that hold
+        // the terminal control guard, and the raw mode lock must not be taken while holding the guard.
+        lock (_initializeLock)
+        {
+            if (_initialized)
+                return;
+
+            Initialize();
+
+            _initialized = true;
+        }
+
+        StartMonitoring();
+    }
+
     private protected abstract bool GetMode();
 
     private protected abstract void SetMode(bool raw, bool flush);
@@ -221,30 +285,131 @@ public abstract class SystemVirtualTerminal : VirtualTerminal
         {
             check?.Invoke(this);
 
+            EnsureInitialized();
             SetMode(raw, flush);
         }
     }
 
     public override sealed void EnableRawMode()
     {
-        using (Control.Guard())
-            ChangeRawMode(
-                raw: true,
-                flush: true,
-                static @this => Check.Operation(
-                    @this._processes.Count == 0,
-                    $"Cannot enable raw mode with non-redirected child processes running."));
+        // The raw mode lock must always be taken before the guard; see ProbeCapabilitiesCore().
+        lock (_rawLock)
+            using (Control.Guard())
+                ChangeRawMode(
+                    raw: true,
+                    flush: true,
+                    static @this => Check.Operation(
+                        @this._processes.Count == 0,
+                        $"Cannot enable raw mode with non-redirected child processes running."));
     }
 
     public override sealed void DisableRawMode()
     {
-        using (Control.Guard())
-            ChangeRawMode(
-                raw: false,
-                flush: true,
-                static @this => Check.Operation(
-                    @this._processes.Count == 0,
-                    $"Cannot disable raw mode with non-redirected child processes running."));
+        // The raw mode lock must always be taken before the guard; see ProbeCapabilitiesCore().
+        lock (_rawLock)
+            using (Control.Guard())
+                ChangeRawMode(
+                    raw: false,
+                    flush: true,
+                    static @this => Check.Operation(
+                        @this._processes.Count == 0,
+                        $"Cannot disable raw mode with non-redirected child processes running."));
+    }
+
+    // These do not enter the terminal control guard; see ProbeCapabilitiesCore().
+    private protected abstract int ReadTerminalIn(scoped Span<byte> buffer, CancellationToken cancellationToken);
+
+    private protected abstract void UnreadTerminalIn(scoped ReadOnlySpan<byte> buffer);
+
+    private protected abstract void WriteTerminalOut(scoped ReadOnlySpan<byte> buffer);
+
+    public TerminalCapabilities ProbeCapabilities()
+    {
+        // The result is cached for the lifetime of the process; the terminal is not going to change underneath us.
+        //
+        // Input that the user types while the probe is in progress is handed back to TerminalIn readers. However, if
+        // the terminal does not answer all queries in time, any pending input is discarded along with late replies
+        // when the probe is over.
+        lock (_capabilitiesLock)
+            return _capabilities ??= ProbeCapabilitiesCore();
+    }
+
+    private TerminalCapabilities ProbeCapabilitiesCore()
+    {
+        // There is no point in probing if the queries or replies would end up somewhere other than the terminal.
+        if (!TerminalIn.IsInteractive || !TerminalOut.IsInteractive)
+            return TerminalCapabilities.Unknown;
+
+        // Hold the raw mode lock for the duration of the probe so that nobody can switch modes or start non-redirected
+        // child processes while we are waiting for replies. The guard is only held while changing the mode and
+        // sending the queries, so that a Control.Acquire() call (e.g. in order to suspend the process) does not have
+        // to wait out the probe timeout. Note that the raw mode lock must always be taken before the guard.
+        lock (_rawLock)
+        {
+            var cooked = false;
+            var complete = false;
+
+            try
+            {
+                using (Control.Guard())
+                {
+                    // Replies are only delivered immediately (and without being echoed) in raw mode, so switch to it
+                    // for the duration of the probe if necessary.
+                    if (!GetMode())
+                    {
+                        ChangeRawMode(
+                            raw: true,
+                            flush: true,
+                            static @this => Check.Operation(
+                                @this._processes.Count == 0,
+                                $"Cannot probe terminal capabilities with non-redirected child processes running."));
+
+                        cooked = true;
+                    }
+
+                    // We already hold the guard, and entering it again could deadlock with a pending Acquire() call.
+                    WriteTerminalOut(TerminalCapabilityProbe.Query);
+                }
+
+                var probe = new TerminalCapabilityProbe();
+                var buffer = (stackalloc byte[256]);
+
+                using var cts = new CancellationTokenSource(_probeTimeout);
+
+                try
+                {
+                    while (!probe.IsComplete)
+                    {
+                        var count = ReadTerminalIn(buffer, cts.Token);
+
+                        // EOF?
+                        if (count == 0)
+                            break;
+
+                        probe.Feed(buffer[..count]);
+                    }
+                }
+                catch (OperationCanceledException) when (cts.IsCancellationRequested)
+                {
+                    // The terminal did not answer all of our queries in time. Go with what we have.
+                }
+
+                complete = probe.IsComplete;
+
+                // Anything that was not a reply is input that the user typed while we were probing.
+                UnreadTerminalIn(probe.Input);
+
+                return probe.ToCapabilities();
+            }
+            finally
+            {
+                // If the terminal answered everything, there is nothing left to discard. Otherwise, flushing discards
+                // any replies that arrive late so that they do not end up as user input.
+                if (cooked)
+                    using (Control.Guard())
+                        ChangeRawMode(raw: false, flush: !complete, check: null);
+            }
+        }
     }
 
     internal void StartProcess(Func<ChildProcess> starter)
@@ -255,6 +420,9 @@ public abstract class SystemVirtualTerminal : VirtualTerminal
             // any child processes that could be using the terminal are running.
             Check.Operation(!IsRawMode, $"Cannot start non-redirected child processes in raw mode.");
 
+            // The child process will expect the terminal to be configured as it would be in cooked mode.
+            EnsureInitialized();
+
             // Guard here since this locks us into cooked mode until all non-redirected processes are gone.
             using (Control.Guard())
                 _ = _processes.Add(starter());
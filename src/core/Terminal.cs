@@ -53,6 +53,12 @@ public static class Terminal
         set => System.SizePollingInterval = value;
     }
 
+    public static TimeSpan CapabilityProbeTimeout
+    {
+        get => System.CapabilityProbeTimeout;
+        set => System.CapabilityProbeTimeout = value;
+    }
+
     [UnsupportedOSPlatform("windows")]
     public static void GenerateSignal(TerminalSignal signal)
     {
@@ -69,6 +75,11 @@ public static class Terminal
         System.DisableRawMode();
     }
 
+    public static TerminalCapabilities ProbeCapabilities()
+    {
+        return System.ProbeCapabilities();
+    }
+
     public static int Read(scoped Span<byte> value)
     {
         return System.Read(value);
@@ -0,0 +1,43 @@
+// SPDX-License-Identifier: 0BSD
+
+using Vezel.Cathode.Text.Control;
+
+namespace Vezel.Cathode;
+
+public sealed class TerminalCapabilities
+{
+    public static TerminalCapabilities Unknown { get; } =
+        new(isResponsive: false, name: null, [], [], false, false, ColorDepth.None);
+
+    public bool IsResponsive { get; }
+
+    public string? Name { get; }
+
+    public ImmutableArray<int> PrimaryAttributes { get; }
+
+    public ImmutableArray<int> SecondaryAttributes { get; }
+
+    public bool SupportsOutputBatching { get; }
+
+    public bool SupportsProgressiveKeyboard { get; }
+
+    public ColorDepth ColorDepth { get; }
+
+    internal TerminalCapabilities(
+        bool isResponsive,
+        string? name,
+        ImmutableArray<int> primaryAttributes,
+        ImmutableArray<int> secondaryAttributes,
+        bool supportsOutputBatching,
+        bool supportsProgressiveKeyboard,
+        ColorDepth colorDepth)
+    {
+        IsResponsive = isResponsive;
+        Name = name;
+        PrimaryAttributes = primaryAttributes;
+        SecondaryAttributes = secondaryAttributes;
+        SupportsOutputBatching = supportsOutputBatching;
+        SupportsProgressiveKeyboard = supportsProgressiveKeyboard;
+        ColorDepth = colorDepth;
+    }
+}
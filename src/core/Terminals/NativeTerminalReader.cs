@@ -10,60 +10,168 @@ internal sealed unsafe class NativeTerminalReader : TerminalReader
     // in a single line (in cooked mode).
     private const int ReadBufferSize = 4096;
 
+    private const int ProbedState = 1 << 0;
+
+    private const int ValidState = 1 << 1;
+
+    private const int InteractiveState = 1 << 2;
+
     public NativeVirtualTerminal Terminal { get; }
 
     public TerminalInterop.TerminalDescriptor* Descriptor { get; }
 
-    public override Stream Stream { get; }
+    public override Stream Stream => _stream ?? CreateStream();
 
-    public override TextReader TextReader { get; }
+    public override TextReader TextReader => _textReader ?? CreateTextReader();
 
-    public override bool IsValid { get; }
+    public override bool IsValid => (GetState() & ValidState) != 0;
 
-    public override bool IsInteractive { get; }
+    public override bool IsInteractive => (GetState() & InteractiveState) != 0;
 
     private readonly SemaphoreSlim _semaphore;
 
+    // Everything below is created on first use. Most programs only ever use a few of the terminal handles, and
+    // short-lived programs in particular should not have to pay for the rest.
+
+    private Stream? _stream;
+
+    private TextReader? _textReader;
+
+    private NativeTerminalWorker? _worker;
+
+    private int _state;
+
+    // Input that was read on behalf of someone else but turned out not to be meant for them, e.g. the user typing while
+    // terminal capabilities are being probed. It is returned before reading anything more from the terminal. Protected
+    // by the semaphore.
+    private ReadOnlyMemory<byte> _unread;
+
     public NativeTerminalReader(
         NativeVirtualTerminal terminal, TerminalInterop.TerminalDescriptor* descriptor, SemaphoreSlim semaphore)
     {
         Terminal = terminal;
         Descriptor = descriptor;
         _semaphore = semaphore;
-        Stream = new SynchronizedStream(new TerminalInputStream(this));
-        TextReader =
+    }
+
+    private Stream CreateStream()
+    {
+        _ = Interlocked.CompareExchange(ref _stream, new SynchronizedStream(new TerminalInputStream(this)), null);
+
+        return _stream;
+    }
+
+    private TextReader CreateTextReader()
+    {
+        _ = Interlocked.CompareExchange(
+            ref _textReader,
             new SynchronizedTextReader(
                 new StreamReader(
                     Stream,
                     Cathode.Terminal.Encoding,
                     detectEncodingFromByteOrderMarks: false,
                     ReadBufferSize,
-                    leaveOpen: true));
-        IsValid = TerminalInterop.IsValid(descriptor, write: false);
-        IsInteractive = TerminalInterop.IsInteractive(descriptor);
+                    leaveOpen: true)),
+            null);
+
+        return _textReader;
+    }
+
+    private NativeTerminalWorker CreateWorker()
+    {
+        _ = Interlocked.CompareExchange(
+            ref _worker,
+            new(
+                Terminal,
+                _semaphore,
+                "Terminal Reader",
+                (buffer, cancellationToken) => ReadPartialUnlocked(buffer.Span, cancellationToken)),
+            null);
+
+        return _worker;
+    }
+
+    private int GetState()
+    {
+        var state = Volatile.Read(ref _state);
+
+        // Racing threads will just compute the same state.
+        if (state == 0)
+        {
+            state = ProbedState;
+
+            if (TerminalInterop.IsValid(Descriptor, write: false))
+                state |= ValidState;
+
+            if (TerminalInterop.IsInteractive(Descriptor))
+                state |= InteractiveState;
+
+            Volatile.Write(ref _state, state);
+        }
+
+        return state;
     }
 
-    private int ReadPartialNative(scoped Span<byte> buffer, CancellationToken cancellationToken)
+    internal int ReadPartialNative(scoped Span<byte> buffer, CancellationToken cancellationToken)
     {
         using (Terminal.Control.Guard())
+            return ReadPartialUnguarded(buffer, cancellationToken);
+    }
+
+    // The caller is responsible for the terminal control guard, if it should be held at all.
+    internal int ReadPartialUnguarded(scoped Span<byte> buffer, CancellationToken cancellationToken)
+    {
+        // If the descriptor is invalid, just present the illusion to the user that it has been redirected to /dev/null
+        // or something along those lines, i.e. return EOF.
+        if (buffer is [] || !IsValid)
+            return 0;
+
+        // Reading from the terminal depends on the terminal mode that we configure.
+        if (IsInteractive)
+            Terminal.EnsureInitialized();
+
+        using (_semaphore.Enter(cancellationToken))
+            return ReadPartialUnlocked(buffer, cancellationToken);
+    }
+
+    // The caller is responsible for the terminal control guard and the semaphore.
+    private int ReadPartialUnlocked(scoped Span<byte> buffer, CancellationToken cancellationToken)
+    {
+        if (!_unread.IsEmpty)
+        {
+            var count = int.Min(buffer.Length, _unread.Length);
+
+            _unread.Span[..count].CopyTo(buffer);
+            _unread = _unread[count..];
+
+            return count;
+        }
+
+        using (Terminal.ArrangeCancellation(Descriptor, write: false, cancellationToken))
+        {
+            int progress;
+
+            fixed (byte* p = buffer)
+                TerminalInterop.Read(Descriptor, p, buffer.Length, &progress).ThrowIfError(cancellationToken);
+
+            return progress;
+        }
+    }
+
+    internal void Unread(scoped ReadOnlySpan<byte> buffer)
+    {
+        if (buffer.IsEmpty)
+            return;
+
+        using (_semaphore.Enter())
         {
-            // If the descriptor is invalid, just present the illusion to the user that it has been redirected to /dev/null
-            // or something along those lines, i.e. return EOF.
-            if (buffer is [] || !IsValid)
-                return 0;
-
-            using (_semaphore.Enter(cancellationToken))
-            {
-                using (Terminal.ArrangeCancellation(Descriptor, write: false, cancellationToken))
-                {
-                    int progress;
-
-                    fixed (byte* p = buffer)
-                        TerminalInterop.Read(Descriptor, p, buffer.Length, &progress).ThrowIfError(cancellationToken);
-
-                    return progress;
-                }
-            }
+            var array = new byte[_unread.Length + buffer.Length];
+
+            // Anything that was already there was read before this data.
+            _unread.Span.CopyTo(array);
+            buffer.CopyTo(array.AsSpan(_unread.Length..));
+
+            _unread = array;
         }
     }
 
@@ -79,4 +187,13 @@ internal sealed unsafe class NativeTerminalReader : TerminalReader
             ? ValueTask.FromCanceled<int>(cancellationToken)
             : new(Task.Run(() => ReadPartialNative(buffer.Span, cancellationToken), cancellationToken));
     }
+
+    private protected override ValueTask<int> FillPipeCoreAsync(
+        Memory<byte> buffer, CancellationToken cancellationToken)
+    {
+        // See ReadPartialUnguarded().
+        return buffer.IsEmpty || !IsValid
+            ? ValueTask.FromResult(0)
+            : (_worker ?? CreateWorker()).RunAsync(buffer, IsInteractive, cancellationToken);
+    }
 }
@@ -0,0 +1,133 @@
+// SPDX-License-Identifier: 0BSD
+
+using System.Threading.Tasks.Sources;
+
+namespace Vezel.Cathode.Terminals;
+
+[SuppressMessage("", "CA1001")]
+internal sealed class NativeTerminalWorker : IValueTaskSource<int>
+{
+    // Pipe adapters perform their blocking terminal operations on this thread rather than queuing a thread pool work
+    // item for every fill or flush. The terminal control guard and the handle's semaphore are held around an entire
+    // operation, so there is never more than one operation in flight, and the operation itself can just loop over the
+    // native calls.
+
+    private readonly NativeVirtualTerminal _terminal;
+
+    private readonly SemaphoreSlim _semaphore;
+
+    private readonly string _name;
+
+    private readonly Func<Memory<byte>, CancellationToken, int> _operation;
+
+    private readonly AutoResetEvent _signal = new(initialState: false);
+
+    private ManualResetValueTaskSourceCore<int> _source = new()
+    {
+        // The continuation must not run on this thread, which would then be stuck until the consumer gets around to
+        // starting the next operation.
+        RunContinuationsAsynchronously = true,
+    };
+
+    private Memory<byte> _buffer;
+
+    private CancellationToken _cancellationToken;
+
+    private Thread? _thread;
+
+    public NativeTerminalWorker(
+        NativeVirtualTerminal terminal,
+        SemaphoreSlim semaphore,
+        string name,
+        Func<Memory<byte>, CancellationToken, int> operation)
+    {
+        _terminal = terminal;
+        _semaphore = semaphore;
+        _name = name;
+        _operation = operation;
+    }
+
+    [AsyncMethodBuilder(typeof(PoolingAsyncValueTaskMethodBuilder<>))]
+    public async ValueTask<int> RunAsync(Memory<byte> buffer, bool interactive, CancellationToken cancellationToken)
+    {
+        // Unlike the thread pool path, no thread is tied up while waiting for the guard and the semaphore.
+        using (await _terminal.Control.GuardAsync().ConfigureAwait(false))
+        {
+            // Reading from and writing to the terminal depends on the terminal mode that we configure.
+            if (interactive)
+                _terminal.EnsureInitialized();
+
+            using (await _semaphore.EnterAsync(cancellationToken).ConfigureAwait(false))
+                return await StartAsync(buffer, cancellationToken).ConfigureAwait(false);
+        }
+    }
+
+    private ValueTask<int> StartAsync(Memory<byte> buffer, CancellationToken cancellationToken)
+    {
+        _source.Reset();
+
+        _buffer = buffer;
+        _cancellationToken = cancellationToken;
+
+        // The thread is started on first use since only the pipe adapters need it.
+        if (_thread == null)
+        {
+            _thread = new(Run)
+            {
+                Name = _name,
+                IsBackground = true,
+            };
+
+            _thread.Start();
+        }
+
+        _ = _signal.Set();
+
+        return new(this, _source.Version);
+    }
+
+    [SuppressMessage("", "CA1031")]
+    private void Run()
+    {
+        while (true)
+        {
+            _ = _signal.WaitOne();
+
+            int result;
+
+            try
+            {
+                result = _operation(_buffer, _cancellationToken);
+            }
+            catch (Exception ex)
+            {
+                _buffer = default;
+
+                _source.SetException(ex);
+
+                continue;
+            }
+
+            // Do not keep the consumer's buffer alive.
+            _buffer = default;
+
+            _source.SetResult(result);
+        }
+    }
+
+    int IValueTaskSource<int>.GetResult(short token)
+    {
+        return _source.GetResult(token);
+    }
+
+    ValueTaskSourceStatus IValueTaskSource<int>.GetStatus(short token)
+    {
+        return _source.GetStatus(token);
+    }
+
+    void IValueTaskSource<int>.OnCompleted(
+        Action<object?> continuation, object? state, short token, ValueTaskSourceOnCompletedFlags flags)
+    {
+        _source.OnCompleted(continuation, state, token, flags);
+    }
+}
@@ -1,5 +1,7 @@
 // SPDX-License-Identifier: 0BSD
 
+using Microsoft.Win32.SafeHandles;
+
 using Vezel.Cathode.Native;
 
 namespace Vezel.Cathode.Terminals;
@@ -9,59 +11,156 @@ internal sealed unsafe class NativeTerminalWriter : TerminalWriter
     // Unlike NativeTerminalReader, the buffer size here is arbitrary and only has performance implications.
     private const int WriteBufferSize = 256;
 
+    // Transfers are split into chunks of this size so that other writers are not locked out for too long, and so that
+    // cancellation is noticed in a timely manner. Waiting for the source to have data happens outside of the locks.
+    private const int TransferChunkSize = 4 * 1024 * 1024;
+
+    private const int ProbedState = 1 << 0;
+
+    private const int ValidState = 1 << 1;
+
+    private const int InteractiveState = 1 << 2;
+
     public NativeVirtualTerminal Terminal { get; }
 
     public TerminalInterop.TerminalDescriptor* Descriptor { get; }
 
-    public override Stream Stream { get; }
+    public override Stream Stream => _stream ?? CreateStream();
 
-    public override TextWriter TextWriter { get; }
+    public override TextWriter TextWriter => _textWriter ?? CreateTextWriter();
 
-    public override bool IsValid { get; }
+    public override bool IsValid => (GetState() & ValidState) != 0;
 
-    public override bool IsInteractive { get; }
+    public override bool IsInteractive => (GetState() & InteractiveState) != 0;
 
     private readonly SemaphoreSlim _semaphore;
 
+    // See NativeTerminalReader.
+
+    private Stream? _stream;
+
+    private TextWriter? _textWriter;
+
+    private NativeTerminalWorker? _worker;
+
+    private int _state;
+
     public NativeTerminalWriter(
         NativeVirtualTerminal terminal, TerminalInterop.TerminalDescriptor* descriptor, SemaphoreSlim semaphore)
     {
         Terminal = terminal;
         Descriptor = descriptor;
         _semaphore = semaphore;
-        Stream = new SynchronizedStream(new TerminalOutputStream(this));
-        TextWriter =
+    }
+
+    private Stream CreateStream()
+    {
+        _ = Interlocked.CompareExchange(ref _stream, new SynchronizedStream(new TerminalOutputStream(this)), null);
+
+        return _stream;
+    }
+
+    [SuppressMessage("", "CA2000")]
+    private TextWriter CreateTextWriter()
+    {
+        _ = Interlocked.CompareExchange(
+            ref _textWriter,
             new SynchronizedTextWriter(
                 new StreamWriter(Stream, Cathode.Terminal.Encoding, WriteBufferSize, leaveOpen: true)
                 {
                     AutoFlush = true,
-                });
-        IsValid = TerminalInterop.IsValid(descriptor, write: true);
-        IsInteractive = TerminalInterop.IsInteractive(descriptor);
+                }),
+            null);
+
+        return _textWriter;
+    }
+
+    private NativeTerminalWorker CreateWorker()
+    {
+        _ = Interlocked.CompareExchange(
+            ref _worker,
+            new(
+                Terminal,
+                _semaphore,
+                "Terminal Writer",
+                (buffer, cancellationToken) => DrainPipeUnlocked(buffer.Span, cancellationToken)),
+            null);
+
+        return _worker;
+    }
+
+    private int GetState()
+    {
+        var state = Volatile.Read(ref _state);
+
+        // Racing threads will just compute the same state.
+        if (state == 0)
+        {
+            state = ProbedState;
+
+            if (TerminalInterop.IsValid(Descriptor, write: true))
+                state |= ValidState;
+
+            if (TerminalInterop.IsInteractive(Descriptor))
+                state |= InteractiveState;
+
+            Volatile.Write(ref _state, state);
+        }
+
+        return state;
     }
 
     private int WritePartialNative(scoped ReadOnlySpan<byte> buffer, CancellationToken cancellationToken)
     {
         using (Terminal.Control.Guard())
+            return WritePartialUnguarded(buffer, cancellationToken);
+    }
+
+    // The caller is responsible for the terminal control guard, if it should be held at all.
+    internal int WritePartialUnguarded(scoped ReadOnlySpan<byte> buffer, CancellationToken cancellationToken)
+    {
+        // If the descriptor is invalid, just present the illusion to the user that it has been redirected to /dev/null
+        // or something along those lines, i.e. pretend we wrote everything.
+        if (buffer is [] || !IsValid)
+            return buffer.Length;
+
+        // Writing to the terminal depends on the terminal mode that we configure.
+        if (IsInteractive)
+            Terminal.EnsureInitialized();
+
+        using (_semaphore.Enter(cancellationToken))
+            return WritePartialUnlocked(buffer, cancellationToken);
+    }
+
+    // The caller is responsible for the terminal control guard and the semaphore.
+    private int WritePartialUnlocked(scoped ReadOnlySpan<byte> buffer, CancellationToken cancellationToken)
+    {
+        using (Terminal.ArrangeCancellation(Descriptor, write: true, cancellationToken))
         {
-            // If the descriptor is invalid, just present the illusion to the user that it has been redirected to /dev/null
-            // or something along those lines, i.e. pretend we wrote everything.
-            if (buffer is [] || !IsValid)
-                return buffer.Length;
+            int progress;
 
-            using (_semaphore.Enter(cancellationToken))
-            {
-                using (Terminal.ArrangeCancellation(Descriptor, write: true, cancellationToken))
-                {
-                    int progress;
+            fixed (byte* p = buffer)
+                TerminalInterop.Write(Descriptor, p, buffer.Length, &progress).ThrowIfError(cancellationToken);
 
-                    fixed (byte* p = buffer)
-                        TerminalInterop.Write(Descriptor, p, buffer.Length, &progress).ThrowIfError(cancellationToken);
+            return progress;
+        }
+    }
 
-                    return progress;
-                }
-            }
+    private int DrainPipeUnlocked(ReadOnlySpan<byte> buffer, CancellationToken cancellationToken)
+    {
+        var written = 0;
+
+        try
+        {
+            while (written < buffer.Length)
+                written += WritePartialUnlocked(buffer[written..], cancellationToken);
         }
+        catch (OperationCanceledException) when (written != 0)
+        {
+            // See TerminalWriter.DrainPipeAsync().
+        }
+
+        return written;
     }
 
     protected override int WritePartialCore(scoped ReadOnlySpan<byte> buffer)
@@ -77,4 +176,95 @@ internal sealed unsafe class NativeTerminalWriter : TerminalWriter
             ? ValueTask.FromCanceled<int>(cancellationToken)
             : new(Task.Run(() => WritePartialNative(buffer.Span, cancellationToken), cancellationToken));
     }
+
+    private protected override ValueTask<int> DrainPipeCoreAsync(
+        ReadOnlyMemory<byte> buffer, CancellationToken cancellationToken)
+    {
+        // See WritePartialUnguarded().
+        return buffer.IsEmpty || !IsValid
+            ? ValueTask.FromResult(buffer.Length)
+            : (_worker ?? CreateWorker()).RunAsync(MemoryMarshal.AsMemory(buffer), IsInteractive, cancellationToken);
+    }
+
+    private long TransferNative(SafeFileHandle handle, long offset, long count, CancellationToken cancellationToken)
+    {
+        // See WritePartialNative().
+        if (!IsValid)
+            return count;
+
+        var added = false;
+
+        handle.DangerousAddRef(ref added);
+
+        // A dedicated pipe ensures that canceling this transfer cannot wake up any other operation.
+        using var pipe = cancellationToken.CanBeCanceled ? new UnixCancellationPipe(write: false) : null;
+
+        try
+        {
+            var source = (int)handle.DangerousGetHandle();
+            var total = 0L;
+
+            while (total < count)
+            {
+                // The source might be a pipe that has no data for a long time. Wait for it before taking the guard and
+                // the semaphore so that other writers and Control.Acquire() are not locked out, and so that the wait
+                // can be canceled. The native side only ever reads what is available from such a source.
+                if (pipe != null)
+                    pipe.PollWithCancellation(source, cancellationToken);
+                else
+                    TerminalInterop.Poll(write: false, &source, results: null, count: 1);
+
+                long progress;
+
+                using (Terminal.Control.Guard())
+                {
+                    if (IsInteractive)
+                        Terminal.EnsureInitialized();
+
+                    using (_semaphore.Enter(cancellationToken))
+                    {
+                        using (Terminal.ArrangeCancellation(Descriptor, write: true, cancellationToken))
+                            TerminalInterop.Transfer(
+                                Descriptor,
+                                source,
+                                offset + total,
+                                long.Min(count - total, TransferChunkSize),
+                                &progress).ThrowIfError(cancellationToken);
+                    }
+                }
+
+                if (progress == 0)
+                    break;
+
+                total += progress;
+            }
+
+            return total;
+        }
+        finally
+        {
+            if (added)
+                handle.DangerousRelease();
+        }
+    }
+
+    protected override long WriteFromCore(SafeFileHandle handle, long offset, long count)
+    {
+        // The native path never sees the data, so it cannot be used if someone needs to observe it.
+        return OperatingSystem.IsWindows() || IsOutputObserved
+            ? base.WriteFromCore(handle, offset, count)
+            : TransferNative(handle, offset, count, CancellationToken.None);
+    }
+
+    protected override ValueTask<long> WriteFromCoreAsync(
+        SafeFileHandle handle, long offset, long count, CancellationToken cancellationToken)
+    {
+        if (OperatingSystem.IsWindows() || IsOutputObserved)
+            return base.WriteFromCoreAsync(handle, offset, count, cancellationToken);
+
+        // We currently have no native async support.
+        return cancellationToken.IsCancellationRequested
+            ? ValueTask.FromCanceled<long>(cancellationToken)
+            : new(Task.Run(() => TransferNative(handle, offset, count, cancellationToken), cancellationToken));
+    }
 }
@@ -4,49 +4,57 @@ using Vezel.Cathode.Native;
 
 namespace Vezel.Cathode.Terminals;
 
+[SuppressMessage("", "CA1001")]
 internal abstract class NativeVirtualTerminal : SystemVirtualTerminal
 {
-    public override sealed NativeTerminalReader StandardIn { get; }
+    public override sealed NativeTerminalReader StandardIn => _standardIn ?? CreateReader(ref _standardIn, 0);
 
-    public override sealed NativeTerminalWriter StandardOut { get; }
+    public override sealed NativeTerminalWriter StandardOut => _standardOut ?? CreateWriter(ref _standardOut, 1);
 
-    public override sealed NativeTerminalWriter StandardError { get; }
+    public override sealed NativeTerminalWriter StandardError => _standardError ?? CreateWriter(ref _standardError, 2);
 
-    public override sealed NativeTerminalReader TerminalIn { get; }
+    public override sealed NativeTerminalReader TerminalIn => _terminalIn ?? CreateReader(ref _terminalIn, 3);
 
-    public override sealed NativeTerminalWriter TerminalOut { get; }
+    public override sealed NativeTerminalWriter TerminalOut => _terminalOut ?? CreateWriter(ref _terminalOut, 4);
 
-    private protected unsafe NativeVirtualTerminal()
+    private readonly SemaphoreSlim _inLock = new(1, 1);
+
+    private readonly SemaphoreSlim _outLock = new(1, 1);
+
+    // The handles are created on first use so that merely accessing Terminal.System does not pay for all five of them.
+    private NativeTerminalReader? _standardIn;
+
+    private NativeTerminalWriter? _standardOut;
+
+    private NativeTerminalWriter? _standardError;
+
+    private NativeTerminalReader? _terminalIn;
+
+    private NativeTerminalWriter? _terminalOut;
+
+    private static unsafe TerminalInterop.TerminalDescriptor* GetDescriptor(int index)
     {
-        // Ensure that the native library is fully loaded and initialized before we do anything terminal-related.
-        TerminalInterop.Initialize();
+        // The index is the position of the descriptor in the parameter list of cathode_get_descriptors().
+        var descriptors = stackalloc TerminalInterop.TerminalDescriptor*[5];
 
-        var inLock = new SemaphoreSlim(1, 1);
-        var outLock = new SemaphoreSlim(1, 1);
+        TerminalInterop.GetDescriptors(
+            &descriptors[0], &descriptors[1], &descriptors[2], &descriptors[3], &descriptors[4]);
 
-        TerminalInterop.TerminalDescriptor* stdIn;
-        TerminalInterop.TerminalDescriptor* stdOut;
-        TerminalInterop.TerminalDescriptor* stdErr;
-        TerminalInterop.TerminalDescriptor* ttyIn;
-        TerminalInterop.TerminalDescriptor* ttyOut;
+        return descriptors[index];
+    }
 
-        TerminalInterop.GetDescriptors(&stdIn, &stdOut, &stdErr, &ttyIn, &ttyOut);
+    private unsafe NativeTerminalReader CreateReader(ref NativeTerminalReader? location, int index)
+    {
+        _ = Interlocked.CompareExchange(ref location, new(this, GetDescriptor(index), _inLock), null);
 
-        NativeTerminalReader CreateReader(TerminalInterop.TerminalDescriptor* descriptor, SemaphoreSlim semaphore)
-        {
-            return new(this, descriptor, semaphore);
-        }
+        return location;
+    }
 
-        NativeTerminalWriter CreateWriter(TerminalInterop.TerminalDescriptor* descriptor, SemaphoreSlim semaphore)
-        {
-            return new(this, descriptor, semaphore);
-        }
+    private unsafe NativeTerminalWriter CreateWriter(ref NativeTerminalWriter? location, int index)
+    {
+        _ = Interlocked.CompareExchange(ref location, new(this, GetDescriptor(index), _outLock), null);
 
-        StandardIn = CreateReader(stdIn, inLock);
-        StandardOut = CreateWriter(stdOut, outLock);
-        StandardError = CreateWriter(stdErr, outLock);
-        TerminalIn = CreateReader(ttyIn, inLock);
-        TerminalOut = CreateWriter(ttyOut, outLock);
+        return location;
     }
 
     internal abstract unsafe IDisposable? ArrangeCancellation(
@@ -60,6 +68,30 @@ internal abstract class NativeVirtualTerminal : SystemVirtualTerminal
         return TerminalInterop.QuerySize(&width, &height) ? new(width, height) : null;
     }
 
+    private protected override sealed int ReadTerminalIn(scoped Span<byte> buffer, CancellationToken cancellationToken)
+    {
+        return TerminalIn.ReadPartialUnguarded(buffer, cancellationToken);
+    }
+
+    private protected override sealed void UnreadTerminalIn(scoped ReadOnlySpan<byte> buffer)
+    {
+        TerminalIn.Unread(buffer);
+    }
+
+    private protected override sealed void WriteTerminalOut(scoped ReadOnlySpan<byte> buffer)
+    {
+        var writer = TerminalOut;
+        var count = 0;
+
+        while (count < buffer.Length)
+            count += writer.WritePartialUnguarded(buffer[count..], CancellationToken.None);
+    }
+
+    private protected override sealed void Initialize()
+    {
+        TerminalInterop.Initialize();
+    }
+
     private protected override sealed bool GetMode()
     {
         return TerminalInterop.GetMode();
@@ -0,0 +1,239 @@
+// SPDX-License-Identifier: 0BSD
+
+using Vezel.Cathode.Text.Control;
+
+using static Vezel.Cathode.Text.Control.ControlConstants;
+
+namespace Vezel.Cathode.Terminals;
+
+internal sealed class TerminalCapabilityProbe
+{
+    // We ask for the progressive keyboard flags, XTVERSION, the state of mode 2026 (synchronized output), DA2, and
+    // finally DA1. Virtually every terminal answers DA1 and terminals answer queries in order, so seeing the DA1 reply
+    // means that we have seen every reply that we are ever going to get; this saves us from waiting for the timeout.
+    public static ReadOnlySpan<byte> Query => "\e[?u\e[>0q\e[?2026$p\e[>c\e[c"u8;
+
+    public bool IsComplete { get; private set; }
+
+    // Anything that is not a reply to one of our queries, most likely the user typing while we probe. It is handed back
+    // to readers of the terminal once the probe is over.
+    public ReadOnlySpan<byte> Input => _input.WrittenSpan;
+
+    private readonly ArrayBufferWriter<byte> _buffer = new(256);
+
+    private readonly ArrayBufferWriter<byte> _input = new();
+
+    private int _position;
+
+    private string? _name;
+
+    private ImmutableArray<int> _primaryAttributes = [];
+
+    private ImmutableArray<int> _secondaryAttributes = [];
+
+    private bool _outputBatching;
+
+    private bool _progressiveKeyboard;
+
+    public void Feed(scoped ReadOnlySpan<byte> data)
+    {
+        // Once we have seen the last reply, everything else is input.
+        if (IsComplete)
+        {
+            _input.Write(data);
+
+            return;
+        }
+
+        _buffer.Write(data);
+
+        var span = _buffer.WrittenSpan;
+
+        while (_position < span.Length)
+        {
+            var remaining = span[_position..];
+
+            if (IsComplete)
+            {
+                _input.Write(remaining);
+                _position = span.Length;
+
+                break;
+            }
+
+            var start = remaining.IndexOf((byte)ESC);
+
+            if (start == -1)
+            {
+                _input.Write(remaining);
+                _position = span.Length;
+
+                break;
+            }
+
+            _input.Write(remaining[..start]);
+
+            var sequence = remaining[start..];
+            var length = Parse(sequence, out var reply);
+
+            // Wait for more data if the sequence is incomplete.
+            if (length == 0)
+            {
+                _position += start;
+
+                break;
+            }
+
+            // Key presses are escape sequences too, so keep anything that was not a reply.
+            if (!reply)
+                _input.Write(sequence[..length]);
+
+            _position += start + length;
+        }
+    }
+
+    public TerminalCapabilities ToCapabilities()
+    {
+        return new(
+            IsComplete,
+            _name,
+            _primaryAttributes,
+            _secondaryAttributes,
+            _outputBatching,
+            _progressiveKeyboard,
+            DetectColorDepth());
+    }
+
+    private static ColorDepth DetectColorDepth()
+    {
+        // We enable virtual terminal processing on Windows, and every console host that supports it also supports
+        // 24-bit colors.
+        if (OperatingSystem.IsWindows())
+            return ColorDepth.TrueColor;
+
+        // There is no widely supported query for color support, so rely on the conventional environment variables.
+        if (Environment.GetEnvironmentVariable("COLORTERM") is "truecolor" or "24bit")
+            return ColorDepth.TrueColor;
+
+        return Environment.GetEnvironmentVariable("TERM") switch
+        {
+            null or "" or "dumb" => ColorDepth.None,
+            var term when term.Contains("256color", StringComparison.Ordinal) => ColorDepth.Extended,
+            _ => ColorDepth.Standard,
+        };
+    }
+
+    private int Parse(scoped ReadOnlySpan<byte> sequence, out bool reply)
+    {
+        reply = false;
+
+        if (sequence.Length < 2)
+            return 0;
+
+        return sequence[1] switch
+        {
+            (byte)'[' => ParseControlSequence(sequence, out reply),
+            (byte)'P' => ParseDeviceControlString(sequence, out reply),
+            _ => 1,
+        };
+    }
+
+    private int ParseControlSequence(scoped ReadOnlySpan<byte> sequence, out bool reply)
+    {
+        reply = false;
+
+        var i = 2;
+        var prefix = (byte)0;
+
+        if (i < sequence.Length && sequence[i] is (byte)'?' or (byte)'>')
+            prefix = sequence[i++];
+
+        var parametersStart = i;
+
+        while (i < sequence.Length && sequence[i] is >= 0x30 and <= 0x3f)
+            i++;
+
+        var parametersEnd = i;
+
+        while (i < sequence.Length && sequence[i] is >= 0x20 and <= 0x2f)
+            i++;
+
+        if (i == sequence.Length)
+            return 0;
+
+        var final = sequence[i];
+
+        // Malformed sequence; skip what we have seen so far.
+        if (final is not (>= 0x40 and <= 0x7e))
+            return i;
+
+        var parameters = ParseParameters(sequence[parametersStart..parametersEnd]);
+        var intermediates = sequence[parametersEnd..i];
+
+        switch ((prefix, intermediates.Length, final))
+        {
+            case ((byte)'?', 0, (byte)'u'):
+                _progressiveKeyboard = true;
+                reply = true;
+                break;
+            case ((byte)'?', 1, (byte)'y') when intermediates[0] == '$' && parameters is [2026, ..]:
+                // DECRPM values 1 (set), 2 (reset), and 3 (permanently set) all mean that the mode can be used.
+                _outputBatching = parameters is [_, >= 1 and <= 3, ..];
+                reply = true;
+                break;
+            case ((byte)'>', 0, (byte)'c'):
+                _secondaryAttributes = parameters;
+                reply = true;
+                break;
+            case ((byte)'?', 0, (byte)'c'):
+                _primaryAttributes = parameters;
+                IsComplete = true;
+                reply = true;
+                break;
+        }
+
+        return i + 1;
+    }
+
+    private int ParseDeviceControlString(scoped ReadOnlySpan<byte> sequence, out bool reply)
+    {
+        reply = false;
+
+        var end = sequence[2..].IndexOf("\e\\"u8);
+
+        if (end == -1)
+            return 0;
+
+        var content = sequence[2..(end + 2)];
+
+        if (content.StartsWith(">|"u8))
+        {
+            _name = Terminal.Encoding.GetString(content[2..]);
+            reply = true;
+        }
+
+        return end + 4;
+    }
+
+    private static ImmutableArray<int> ParseParameters(scoped ReadOnlySpan<byte> parameters)
+    {
+        if (parameters.IsEmpty)
+            return [];
+
+        var builder = ImmutableArray.CreateBuilder<int>();
+
+        foreach (var range in parameters.Split((byte)';'))
+        {
+            var parameter = parameters[range];
+
+            // Ignore sub-parameters.
+            if (parameter.IndexOf((byte)':') is var colon and not -1)
+                parameter = parameter[..colon];
+
+            builder.Add(
+                int.TryParse(parameter, NumberStyles.None, CultureInfo.InvariantCulture, out var value) ? value : 0);
+        }
+
+        return builder.DrainToImmutable();
+    }
+}
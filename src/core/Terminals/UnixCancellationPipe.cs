@@ -4,8 +4,7 @@ using Vezel.Cathode.Native;
 
 namespace Vezel.Cathode.Terminals;
 
-[SuppressMessage("", "CA1001")]
-internal sealed class UnixCancellationPipe
+internal sealed class UnixCancellationPipe : IDisposable
 {
     // TODO: Move this logic to src/native/driver-unix.c.
 
@@ -22,6 +21,12 @@ internal sealed class UnixCancellationPipe
         _write = write;
     }
 
+    public void Dispose()
+    {
+        _client.Dispose();
+        _server.Dispose();
+    }
+
     public unsafe void PollWithCancellation(int fd, CancellationToken cancellationToken)
     {
         // Note that the runtime sets up a SIGPIPE handler for us.
@@ -6,68 +6,99 @@ namespace Vezel.Cathode.Terminals;
 
 internal sealed class UnixVirtualTerminal : NativeVirtualTerminal
 {
-    public override event Action? Resumed;
+    public override event Action? Resumed
+    {
+        add
+        {
+            _resumed += value;
+
+            StartMonitoring();
+        }
+
+        remove => _resumed -= value;
+    }
 
     public static UnixVirtualTerminal Instance { get; } = new();
 
-    private readonly UnixCancellationPipe _readPipe = new(write: false);
+    private readonly Lock _monitorLock = new();
 
-    private readonly UnixCancellationPipe _writePipe = new(write: true);
+    private UnixCancellationPipe? _readPipe;
 
-    private readonly PosixSignalRegistration _sigWinch;
+    private UnixCancellationPipe? _writePipe;
 
-    private readonly PosixSignalRegistration _sigCont;
+    private Action? _resumed;
 
-    private readonly PosixSignalRegistration _sigChld;
+    // Keep the registrations alive by storing them in fields.
+    private PosixSignalRegistration? _sigWinch;
 
-    public UnixVirtualTerminal()
+    private PosixSignalRegistration? _sigCont;
+
+    private PosixSignalRegistration? _sigChld;
+
+    private protected override void StartMonitoring()
     {
-        void HandleSignal(PosixSignalContext context)
+        // The signals are only interesting once the terminal has been configured, a child process has been started, or
+        // the program is listening for Resized/Resumed, so do not register them until one of those things happens.
+        lock (_monitorLock)
         {
-            // If we are being restored from the background (SIGCONT), it is possible and likely that terminal settings
-            // have been mangled, so restore them.
-            //
-            // This is a best-effort thing. The reality is that, since this signal handler method gets called in a
-            // thread after the process has fully woken up, other code may already be trying to interact with the
-            // terminal again. There is nothing we can really do about this race condition.
-            if (context.Signal == PosixSignal.SIGCONT)
+            if (_sigWinch != null)
+                return;
+
+            _sigWinch = PosixSignalRegistration.Create(PosixSignal.SIGWINCH, HandleSignal);
+            _sigCont = PosixSignalRegistration.Create(PosixSignal.SIGCONT, HandleSignal);
+            _sigChld = PosixSignalRegistration.Create(PosixSignal.SIGCHLD, HandleSignal);
+        }
+    }
+
+    private void HandleSignal(PosixSignalContext context)
+    {
+        // If we are being restored from the background (SIGCONT), it is possible and likely that terminal settings
+        // have been mangled, so restore them.
+        //
+        // This is a best-effort thing. The reality is that, since this signal handler method gets called in a thread
+        // after the process has fully woken up, other code may already be trying to interact with the terminal again.
+        // There is nothing we can really do about this race condition.
+        if (context.Signal == PosixSignal.SIGCONT)
+        {
+            try
             {
-                try
-                {
-                    ChangeRawMode(IsRawMode, flush: false, check: null);
-                }
-                catch (Exception e) when (e is TerminalNotAttachedException or TerminalConfigurationException)
-                {
-                    // Either there was no terminal attached to begin with, or it has disappeared since we were stopped.
-                    // In either case, the program can no longer read from or write to the terminal, so terminal
-                    // settings are irrelevant.
-                }
-
-                // Do this on the thread pool to avoid breaking internals if an event handler misbehaves.
-                _ = ThreadPool.UnsafeQueueUserWorkItem(
-                    static @this => @this.Resumed?.Invoke(), this, preferLocal: true);
+                ChangeRawMode(IsRawMode, flush: false, check: null);
+            }
+            catch (Exception e) when (e is TerminalNotAttachedException or TerminalConfigurationException)
+            {
+                // Either there was no terminal attached to begin with, or it has disappeared since we were stopped. In
+                // either case, the program can no longer read from or write to the terminal, so terminal settings are
+                // irrelevant.
             }
 
-            // Terminal width/height will definitely have changed for SIGWINCH, and might have changed for SIGCONT and
-            // SIGCHLD. On Unix systems, signals let us respond much more quickly to a change in terminal size.
-            RefreshSize();
-
-            // Prevent System.Native from overwriting our terminal settings.
-            context.Cancel = true;
+            // Do this on the thread pool to avoid breaking internals if an event handler misbehaves.
+            _ = ThreadPool.UnsafeQueueUserWorkItem(
+                static @this => @this._resumed?.Invoke(), this, preferLocal: true);
         }
 
-        // Keep the registrations alive by storing them in fields.
-        _sigWinch = PosixSignalRegistration.Create(PosixSignal.SIGWINCH, HandleSignal);
-        _sigCont = PosixSignalRegistration.Create(PosixSignal.SIGCONT, HandleSignal);
-        _sigChld = PosixSignalRegistration.Create(PosixSignal.SIGCHLD, HandleSignal);
+        // Terminal width/height will definitely have changed for SIGWINCH, and might have changed for SIGCONT and
+        // SIGCHLD. On Unix systems, signals let us respond much more quickly to a change in terminal size.
+        RefreshSize();
+
+        // Prevent System.Native from overwriting our terminal settings.
+        context.Cancel = true;
     }
 
+    [SuppressMessage("", "CA2000")]
     internal override unsafe IDisposable? ArrangeCancellation(
         TerminalInterop.TerminalDescriptor* descriptor, bool write, CancellationToken cancellationToken)
     {
         if (cancellationToken.CanBeCanceled)
-            (write ? _writePipe : _readPipe).PollWithCancellation(*(int*)descriptor, cancellationToken);
+            (write ? _writePipe ?? CreatePipe(ref _writePipe, write) : _readPipe ?? CreatePipe(ref _readPipe, write))
+                .PollWithCancellation(*(int*)descriptor, cancellationToken);
 
         return null;
     }
+
+    private UnixCancellationPipe CreatePipe(ref UnixCancellationPipe? location, bool write)
+    {
+        // Creating the pipe under a lock ensures that we do not leak file descriptors if multiple threads race here.
+        lock (_monitorLock)
+            return location ??= new(write);
+    }
 }
@@ -0,0 +1,11 @@
+// SPDX-License-Identifier: 0BSD
+
+namespace Vezel.Cathode.Text.Control;
+
+public enum ColorDepth
+{
+    None = 0,
+    Standard = 1,
+    Extended = 2,
+    TrueColor = 3,
+}
@@ -0,0 +1,130 @@
+// SPDX-License-Identifier: 0BSD
+
+namespace Vezel.Cathode.Text.Control;
+
+internal static class ColorQuantizer
+{
+    // Colors are reduced to 5 bits per channel and mapped to palette indexes through precomputed tables, so quantizing
+    // a color is a single table lookup rather than a nearest color search.
+    private const int ChannelBits = 5;
+
+    private const int ChannelSize = 1 << ChannelBits;
+
+    // These are the xterm defaults. Indexes 0-15 are commonly themed by users, so we only map to those when the
+    // terminal has nothing else to offer.
+    private static ReadOnlySpan<byte> StandardPalette =>
+    [
+        0, 0, 0,
+        205, 0, 0,
+        0, 205, 0,
+        205, 205, 0,
+        0, 0, 238,
+        205, 0, 205,
+        0, 205, 205,
+        229, 229, 229,
+        127, 127, 127,
+        255, 0, 0,
+        0, 255, 0,
+        255, 255, 0,
+        92, 92, 255,
+        255, 0, 255,
+        0, 255, 255,
+        255, 255, 255,
+    ];
+
+    private static ReadOnlySpan<byte> CubeLevels => [0, 95, 135, 175, 215, 255];
+
+    private static readonly byte[] _standardTable = CreateTable(FindStandard);
+
+    private static readonly byte[] _extendedTable = CreateTable(FindExtended);
+
+    private static byte[] CreateTable(Func<int, int, int, byte> finder)
+    {
+        var table = new byte[ChannelSize * ChannelSize * ChannelSize];
+
+        // Expand each 5-bit channel value back to 8 bits such that 0 and 31 map to 0 and 255, respectively.
+        static int Expand(int value)
+        {
+            return (value << (8 - ChannelBits)) | (value >> ((ChannelBits * 2) - 8));
+        }
+
+        for (var r = 0; r < ChannelSize; r++)
+            for (var g = 0; g < ChannelSize; g++)
+                for (var b = 0; b < ChannelSize; b++)
+                    table[GetKey(r, g, b)] = finder(Expand(r), Expand(g), Expand(b));
+
+        return table;
+    }
+
+    private static int GetKey(int r, int g, int b)
+    {
+        return (r << (ChannelBits * 2)) | (g << ChannelBits) | b;
+    }
+
+    private static int GetDistance(int r1, int g1, int b1, int r2, int g2, int b2)
+    {
+        var (dr, dg, db) = (r1 - r2, g1 - g2, b1 - b2);
+
+        // A cheap approximation of perceptual distance; the eye is most sensitive to green and least to blue.
+        return (2 * dr * dr) + (4 * dg * dg) + (3 * db * db);
+    }
+
+    private static byte FindStandard(int r, int g, int b)
+    {
+        var palette = StandardPalette;
+        var best = 0;
+        var bestDistance = int.MaxValue;
+
+        for (var i = 0; i < palette.Length / 3; i++)
+        {
+            var distance = GetDistance(r, g, b, palette[i * 3], palette[(i * 3) + 1], palette[(i * 3) + 2]);
+
+            if (distance < bestDistance)
+                (best, bestDistance) = (i, distance);
+        }
+
+        return (byte)best;
+    }
+
+    private static byte FindExtended(int r, int g, int b)
+    {
+        // The 6x6x6 color cube (16-231) can be searched per channel.
+        static int FindLevel(int value)
+        {
+            return value switch
+            {
+                < 48 => 0,
+                < 115 => 1,
+                _ => (value - 35) / 40,
+            };
+        }
+
+        var levels = CubeLevels;
+        var (cr, cg, cb) = (FindLevel(r), FindLevel(g), FindLevel(b));
+        var cubeDistance = GetDistance(r, g, b, levels[cr], levels[cg], levels[cb]);
+
+        // The grayscale ramp (232-255) goes from 8 to 238 in steps of 10.
+        var gray = Math.Clamp((((r + g + b) / 3) - 3) / 10, 0, 23);
+        var grayLevel = 8 + (gray * 10);
+        var grayDistance = GetDistance(r, g, b, grayLevel, grayLevel, grayLevel);
+
+        return (byte)(grayDistance < cubeDistance ? 232 + gray : 16 + (cr * 36) + (cg * 6) + cb);
+    }
+
+    private static int GetKey(Color color)
+    {
+        const int shift = 8 - ChannelBits;
+
+        return GetKey(color.R >> shift, color.G >> shift, color.B >> shift);
+    }
+
+    public static int ToStandard(Color color)
+    {
+        return _standardTable[GetKey(color)];
+    }
+
+    public static int ToExtended(Color color)
+    {
+        return _extendedTable[GetKey(color)];
+    }
+}
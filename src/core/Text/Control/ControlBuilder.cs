@@ -121,12 +121,25 @@ public sealed class ControlBuilder
 
     public ReadOnlyMemory<char> Memory => _writer.WrittenMemory;
 
+    public ColorDepth ColorDepth
+    {
+        get => _colorDepth;
+        set
+        {
+            Check.Enum(value);
+
+            _colorDepth = value;
+        }
+    }
+
     private static readonly CultureInfo _culture = CultureInfo.InvariantCulture;
 
     private readonly int _capacity;
 
     private ArrayBufferWriter<char> _writer;
 
+    private ColorDepth _colorDepth = ColorDepth.TrueColor;
+
     public ControlBuilder(int capacity = 1024)
     {
         Check.Range(capacity > 0, capacity);
@@ -582,52 +595,69 @@ public sealed class ControlBuilder
         return Print([ESC]).Print("8");
     }
 
-    public ControlBuilder SetForegroundColor(Color color)
+    private ControlBuilder SetColor(Color color, string type, int standard, int bright)
     {
         Check.Argument(color.A == byte.MaxValue, color);
 
-        var rSpan = (stackalloc char[StackBufferSize]);
-        var gSpan = (stackalloc char[StackBufferSize]);
-        var bSpan = (stackalloc char[StackBufferSize]);
+        switch (_colorDepth)
+        {
+            case ColorDepth.None:
+                return this;
+            case ColorDepth.Standard when standard != 0:
+            {
+                // The 16 standard colors have dedicated SGR codes which are shorter than the indexed form.
+                var index = ColorQuantizer.ToStandard(color);
+                var codeSpan = (stackalloc char[StackBufferSize]);
 
-        _ = color.R.TryFormat(rSpan, out var rLen, provider: _culture);
-        _ = color.G.TryFormat(gSpan, out var gLen, provider: _culture);
-        _ = color.B.TryFormat(bSpan, out var bLen, provider: _culture);
+                _ = (index < 8 ? standard + index : bright + index - 8).TryFormat(
+                    codeSpan, out var codeLen, provider: _culture);
 
-        return Print(CSI).Print("38;2;").Print(rSpan[..rLen]).Print(";")
-            .Print(gSpan[..gLen]).Print(";").Print(bSpan[..bLen]).Print("m");
-    }
+                return Print(CSI).Print(codeSpan[..codeLen]).Print("m");
+            }
 
-    public ControlBuilder SetBackgroundColor(Color color)
-    {
-        Check.Argument(color.A == byte.MaxValue, color);
+            case ColorDepth.Standard:
+            case ColorDepth.Extended:
+            {
+                var index = _colorDepth == ColorDepth.Standard
+                    ? ColorQuantizer.ToStandard(color)
+                    : ColorQuantizer.ToExtended(color);
+                var indexSpan = (stackalloc char[StackBufferSize]);
 
-        var rSpan = (stackalloc char[StackBufferSize]);
-        var gSpan = (stackalloc char[StackBufferSize]);
-        var bSpan = (stackalloc char[StackBufferSize]);
+                _ = index.TryFormat(indexSpan, out var indexLen, provider: _culture);
 
-        _ = color.R.TryFormat(rSpan, out var rLen, provider: _culture);
-        _ = color.G.TryFormat(gSpan, out var gLen, provider: _culture);
-        _ = color.B.TryFormat(bSpan, out var bLen, provider: _culture);
+                return Print(CSI).Print(type).Print(";5;").Print(indexSpan[..indexLen]).Print("m");
+            }
+
+            default:
+            {
+                var rSpan = (stackalloc char[StackBufferSize]);
+                var gSpan = (stackalloc char[StackBufferSize]);
+                var bSpan = (stackalloc char[StackBufferSize]);
+
+                _ = color.R.TryFormat(rSpan, out var rLen, provider: _culture);
+                _ = color.G.TryFormat(gSpan, out var gLen, provider: _culture);
+                _ = color.B.TryFormat(bSpan, out var bLen, provider: _culture);
 
-        return Print(CSI).Print("48;2;").Print(rSpan[..rLen]).Print(";")
-            .Print(gSpan[..gLen]).Print(";").Print(bSpan[..bLen]).Print("m");
+                return Print(CSI).Print(type).Print(";2;").Print(rSpan[..rLen]).Print(";")
+                    .Print(gSpan[..gLen]).Print(";").Print(bSpan[..bLen]).Print("m");
+            }
+        }
     }
 
-    public ControlBuilder SetUnderlineColor(Color color)
+    public ControlBuilder SetForegroundColor(Color color)
     {
-        Check.Argument(color.A == byte.MaxValue, color);
-
-        var rSpan = (stackalloc char[StackBufferSize]);
-        var gSpan = (stackalloc char[StackBufferSize]);
-        var bSpan = (stackalloc char[StackBufferSize]);
+        return SetColor(color, "38", standard: 30, bright: 90);
+    }
 
-        _ = color.R.TryFormat(rSpan, out var rLen, provider: _culture);
-        _ = color.G.TryFormat(gSpan, out var gLen, provider: _culture);
-        _ = color.B.TryFormat(bSpan, out var bLen, provider: _culture);
+    public ControlBuilder SetBackgroundColor(Color color)
+    {
+        return SetColor(color, "48", standard: 40, bright: 100);
+    }
 
-        return Print(CSI).Print("58;2;").Print(rSpan[..rLen]).Print(";")
-            .Print(gSpan[..gLen]).Print(";").Print(bSpan[..bLen]).Print("m");
+    public ControlBuilder SetUnderlineColor(Color color)
+    {
+        // There are no dedicated SGR codes for underline colors.
+        return SetColor(color, "58", standard: 0, bright: 0);
     }
 
     public ControlBuilder SetDecorations(
@@ -319,7 +319,7 @@ public static class ControlSequences
 
     public static string SetBackgroundColor(Color color)
     {
-        return Create(static (cb, color) => cb.SetForegroundColor(color), color);
+        return Create(static (cb, color) => cb.SetBackgroundColor(color), color);
     }
 
     public static string SetUnderlineColor(Color color)
@@ -0,0 +1,346 @@
+// SPDX-License-Identifier: 0BSD
+
+using Vezel.Cathode.Text.Control;
+
+namespace Vezel.Cathode.Text;
+
+public sealed class LiveRegion : IDisposable
+{
+    public VirtualTerminal Terminal { get; }
+
+    public int Height { get; }
+
+    public bool IsInteractive { get; }
+
+    public TimeSpan FrameInterval
+    {
+        get => _frameInterval;
+        set
+        {
+            Check.Range(value > TimeSpan.Zero, value);
+
+            _frameInterval = value;
+        }
+    }
+
+    public string this[int line]
+    {
+        get
+        {
+            Check.Range(line >= 0 && line < Height, line);
+
+            lock (_lock)
+                return _lines[line];
+        }
+        set
+        {
+            Check.Range(line >= 0 && line < Height, line);
+            Check.Null(value);
+
+            lock (_lock)
+            {
+                ObjectDisposedException.ThrowIf(_disposed, this);
+
+                if (_lines[line] == value)
+                    return;
+
+                _lines[line] = value;
+
+                ScheduleFrame();
+            }
+        }
+    }
+
+    // Terminal writes can block for a long time, so they happen without holding _lock. This lock keeps frames from
+    // being written out of order and protects _builder. It must be taken before _lock.
+    private readonly Lock _writeLock = new();
+
+    private readonly Lock _lock = new();
+
+    private readonly string[] _lines;
+
+    // What is currently on the screen; null means that the line must be drawn regardless of its content.
+    private readonly string?[] _drawn;
+
+    private readonly ControlBuilder _builder = new();
+
+    private readonly Timer _timer;
+
+    private TimeSpan _frameInterval = TimeSpan.FromSeconds(1) / 30;
+
+    private long _lastFrame;
+
+    // The size that the region was last established for. Querying the terminal again could fail or disagree with the
+    // layout that is actually on the screen.
+    private Size _size;
+
+    private bool _scheduled;
+
+    private bool _established;
+
+    private int _visible;
+
+    private bool _disposed;
+
+    public LiveRegion(int height)
+        : this(Cathode.Terminal.System, height)
+    {
+    }
+
+    public LiveRegion(VirtualTerminal terminal, int height)
+    {
+        Check.Null(terminal);
+        Check.Range(height > 0, height);
+
+        Terminal = terminal;
+        Height = height;
+        IsInteractive = terminal.TerminalOut.IsInteractive;
+
+        _lines = new string[height];
+        _drawn = new string?[height];
+
+        Array.Fill(_lines, string.Empty);
+
+        _timer = new(static state => Unsafe.As<LiveRegion>(state!).Render(), this, Timeout.Infinite, Timeout.Infinite);
+
+        if (!IsInteractive)
+            return;
+
+        terminal.Resized += HandleResized;
+
+        lock (_writeLock)
+        {
+            lock (_lock)
+                Establish(terminal.Size);
+
+            Flush();
+        }
+    }
+
+    public void Dispose()
+    {
+        try
+        {
+            lock (_writeLock)
+            {
+                lock (_lock)
+                {
+                    if (_disposed)
+                        return;
+
+                    // Plain output has no region to tear down, but the final state should not be lost.
+                    if (!IsInteractive && _scheduled)
+                        RenderPlain();
+
+                    _disposed = true;
+
+                    if (_established)
+                    {
+                        // Give the reserved lines back to regular output.
+                        _ = _builder
+                            .SaveCursorState()
+                            .ResetScrollMargin()
+                            .RestoreCursorState()
+                            .SaveCursorState()
+                            .MoveCursorTo(_size.Height - _visible, 0)
+                            .ClearScreen(ClearMode.After)
+                            .RestoreCursorState();
+
+                        _established = false;
+                    }
+                }
+
+                Flush();
+            }
+        }
+        finally
+        {
+            Terminal.Resized -= HandleResized;
+
+            _timer.Dispose();
+        }
+    }
+
+    private void HandleResized(Size size)
+    {
+        lock (_writeLock)
+        {
+            lock (_lock)
+            {
+                if (_disposed)
+                    return;
+
+                // The terminal may have reflowed its contents, so the old region could be anywhere. Clear everything
+                // below the cursor, which is where it would normally be, and start over.
+                if (_established)
+                    _ = _builder
+                        .SaveCursorState()
+                        .ResetScrollMargin()
+                        .RestoreCursorState()
+                        .ClearScreen(ClearMode.After);
+
+                Establish(size);
+            }
+
+            Flush();
+        }
+    }
+
+    private void Establish(Size size)
+    {
+        // We need at least one line for regular output to scroll in, and SetScrollMargin() requires a range of at least
+        // two lines. If the terminal is too small, we just draw nothing until it is resized.
+        _visible = int.Clamp(size.Height - 2, 0, Height);
+        _established = _visible != 0;
+
+        if (_established)
+        {
+            // Make room for the region by scrolling regular output up if the cursor is near the bottom of the screen.
+            // Setting the scroll margin moves the cursor to the home position, so we have to save it.
+            for (var i = 0; i < _visible; i++)
+                _ = _builder.Print("\n");
+
+            _ = _builder
+                .MoveCursorUp(_visible)
+                .SaveCursorState()
+                .SetScrollMargin(0, size.Height - _visible - 1)
+                .RestoreCursorState();
+        }
+
+        _size = size;
+
+        Array.Fill(_drawn, null);
+
+        ScheduleFrame();
+    }
+
+    private void ScheduleFrame()
+    {
+        if (_scheduled)
+            return;
+
+        _scheduled = true;
+
+        // Coalesce updates that arrive within the same frame.
+        var delay = _frameInterval - Stopwatch.GetElapsedTime(_lastFrame);
+
+        _ = _timer.Change(delay > TimeSpan.Zero ? delay : TimeSpan.Zero, Timeout.InfiniteTimeSpan);
+    }
+
+    [SuppressMessage("", "CA1031")]
+    private void Render()
+    {
+        lock (_writeLock)
+        {
+            try
+            {
+                lock (_lock)
+                {
+                    if (_disposed || !_scheduled)
+                        return;
+
+                    if (IsInteractive)
+                        RenderInteractive();
+                    else
+                        RenderPlain();
+                }
+
+                Flush();
+            }
+            catch (Exception)
+            {
+                // This runs on a timer thread where an exception would take down the process. There is nothing useful
+                // we can do if the terminal cannot be written to anyway.
+                _builder.Clear();
+            }
+        }
+    }
+
+    private void RenderInteractive()
+    {
+        _scheduled = false;
+        _lastFrame = Stopwatch.GetTimestamp();
+
+        if (!_established)
+            return;
+
+        var top = _size.Height - _visible;
+        var changed = false;
+
+        _ = _builder.SetOutputBatching(true).SaveCursorState();
+
+        for (var i = 0; i < _visible; i++)
+        {
+            var line = _lines[i];
+
+            if (line == _drawn[i])
+                continue;
+
+            _ = _builder.MoveCursorTo(top + i, 0).ClearLine().Print(Truncate(line, _size.Width));
+
+            _drawn[i] = line;
+            changed = true;
+        }
+
+        _ = _builder.RestoreCursorState().SetOutputBatching(false);
+
+        if (!changed)
+            _builder.Clear();
+    }
+
+    private void RenderPlain()
+    {
+        _scheduled = false;
+        _lastFrame = Stopwatch.GetTimestamp();
+
+        for (var i = 0; i < _lines.Length; i++)
+        {
+            var line = _lines[i];
+
+            if (line == _drawn[i])
+                continue;
+
+            _drawn[i] = line;
+
+            if (line.Length != 0)
+                _ = _builder.PrintLine(line);
+        }
+    }
+
+    private void Flush()
+    {
+        if (_builder.Span.IsEmpty)
+            return;
+
+        // The whole frame goes out in a single write so that regular output cannot end up in the middle of it, where it
+        // would be printed inside the region.
+        try
+        {
+            (IsInteractive ? Terminal.TerminalOut : Terminal.StandardOut).Write(_builder.Span);
+        }
+        finally
+        {
+            _builder.Clear();
+        }
+    }
+
+    private static ReadOnlySpan<char> Truncate(string line, int width)
+    {
+        // A line that is too long would wrap and scroll the entire screen, destroying the region. Escape sequences in
+        // the line are counted as if they were printed, so a styled line may get truncated a bit early.
+        var columns = 0;
+        var length = 0;
+
+        foreach (var rune in line.EnumerateRunes())
+        {
+            columns += MonospaceWidth.Measure(rune) ?? 0;
+
+            if (columns > width)
+                break;
+
+            length += rune.Utf16SequenceLength;
+        }
+
+        return line.AsSpan(..length);
+    }
+}
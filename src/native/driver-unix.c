@@ -5,9 +5,22 @@
 #include <errno.h>
 #include <fcntl.h>
 #include <poll.h>
+#include <pthread.h>
 #include <signal.h>
+#include <spawn.h>
+#include <stdlib.h>
 #include <sys/ioctl.h>
+#include <sys/resource.h>
+#if defined(ZIG_OS_LINUX)
+#   include <sys/sendfile.h>
+#elif defined(ZIG_OS_MACOS)
+#   include <sys/socket.h>
+#   include <sys/uio.h>
+#endif
+#include <sys/stat.h>
+#include <sys/wait.h>
 #include <termios.h>
+#include <time.h>
 #include <unistd.h>
 
 #include "driver-unix.h"
@@ -17,10 +30,18 @@ struct TerminalDescriptor
     int fd;
 };
 
+struct TerminalProcess
+{
+    pid_t pid;
+    struct timespec start;
+    struct timespec end;
+};
+
 static TerminalDescriptor stdio_in;
 static TerminalDescriptor stdio_out;
 static TerminalDescriptor stdio_err;
 static TerminalDescriptor tty;
+static pthread_once_t tty_once = PTHREAD_ONCE_INIT;
 static struct termios original_termios;
 static bool original_termios_saved;
 static bool raw_mode;
@@ -33,7 +54,7 @@ static void constructor(void)
     stdio_in.fd = STDIN_FILENO;
     stdio_out.fd = STDOUT_FILENO;
     stdio_err.fd = STDERR_FILENO;
-    tty.fd = open("/dev/tty", O_RDWR | O_NOCTTY | O_CLOEXEC);
+    tty.fd = -1;
 }
 
 [[gnu::destructor]]
@@ -42,7 +63,24 @@ static void destructor(void)
     if (original_termios_saved)
         tcsetattr(tty.fd, TCSAFLUSH, &original_termios);
 
-    close(tty.fd);
+    if (tty.fd != -1)
+        close(tty.fd);
+}
+
+static void open_tty(void)
+{
+    tty.fd = open("/dev/tty", O_RDWR | O_NOCTTY | O_CLOEXEC);
+}
+
+static int get_fd(const TerminalDescriptor *nonnull descriptor)
+{
+    assert(descriptor);
+
+    // Most programs never touch the terminal device directly, so only open it once something actually needs it.
+    if (descriptor == &tty)
+        pthread_once(&tty_once, open_tty);
+
+    return descriptor->fd;
 }
 
 void cathode_get_descriptors(
@@ -68,14 +106,14 @@ bool cathode_is_valid(const TerminalDescriptor *nonnull descriptor, bool)
 {
     assert(descriptor);
 
-    return descriptor->fd >= 0;
+    return get_fd(descriptor) >= 0;
 }
 
 bool cathode_is_interactive(const TerminalDescriptor *nonnull descriptor)
 {
     assert(descriptor);
 
-    return isatty(descriptor->fd) == 1;
+    return isatty(get_fd(descriptor)) == 1;
 }
 
 bool cathode_query_size(int32_t *nonnull width, int32_t *nonnull height)
@@ -85,7 +123,7 @@ bool cathode_query_size(int32_t *nonnull width, int32_t *nonnull height)
 
     struct winsize size;
 
-    if (ioctl(tty.fd, TIOCGWINSZ, &size))
+    if (ioctl(get_fd(&tty), TIOCGWINSZ, &size))
         return false;
 
     *width = size.ws_col;
@@ -140,7 +178,7 @@ TerminalResult cathode_set_mode(bool raw, bool flush)
 {
     struct termios termios;
 
-    if (tcgetattr(tty.fd, &termios) == -1)
+    if (tcgetattr(get_fd(&tty), &termios) == -1)
         return (TerminalResult)
         {
             .exception = TerminalException_TerminalNotAttached,
@@ -330,7 +368,7 @@ TerminalResult cathode_read(
 
         // Note that this call may get us suspended by way of a SIGTTIN signal if we are a background process and the
         // handle refers to a terminal.
-        while ((ret = read(descriptor->fd, buffer, (size_t)length)) == -1 && errno == EINTR)
+        while ((ret = read(get_fd(descriptor), buffer, (size_t)length)) == -1 && errno == EINTR)
         {
             // Retry in case we get interrupted by a signal.
         }
@@ -382,7 +420,7 @@ TerminalResult cathode_write(
         // Note that this call may get us suspended by way of a SIGTTOU signal if we are a background process, the
         // handle refers to a terminal, and the TOSTOP bit is set (we disable TOSTOP but there are ways that it could
         // get set anyway).
-        while ((ret = write(descriptor->fd, buffer, (size_t)length)) == -1 && errno == EINTR)
+        while ((ret = write(get_fd(descriptor), buffer, (size_t)length)) == -1 && errno == EINTR)
         {
             // Retry in case we get interrupted by a signal.
         }
@@ -420,6 +458,191 @@ TerminalResult cathode_write(
     }
 }
 
+static bool is_transfer_unsupported(int error)
+{
+    // These all indicate that the kernel cannot move data between this particular pair of descriptors.
+    return error == EINVAL || error == ENOSYS || error == EXDEV || error == EOPNOTSUPP || error == ESPIPE ||
+        error == ENOTSOCK;
+}
+
+static ssize_t transfer_kernel(int out, int source, off_t offset, size_t length)
+{
+#if defined(ZIG_OS_LINUX)
+    ssize_t ret = -1;
+    struct stat st;
+
+    errno = EINVAL;
+
+    // copy_file_range lets the file system share extents or do the copy server-side. Note that it fails with EBADF if
+    // the output was opened with O_APPEND, as is the case for >> redirections.
+    if (fstat(out, &st) != -1 && S_ISREG(st.st_mode))
+    {
+        off_t pos = offset;
+
+        while ((ret = copy_file_range(source, &pos, out, nullptr, length, 0)) == -1 && errno == EINTR)
+        {
+            // Retry in case we get interrupted by a signal.
+        }
+
+        if (ret == -1 && errno == EBADF)
+            errno = EINVAL;
+    }
+
+    // sendfile can write to any kind of descriptor, but the source must support mmap, i.e. be a regular file.
+    if (ret == -1 && is_transfer_unsupported(errno))
+    {
+        off_t pos = offset;
+
+        while ((ret = sendfile(out, source, &pos, length)) == -1 && errno == EINTR)
+        {
+            // Retry in case we get interrupted by a signal.
+        }
+    }
+
+    // If the source is a pipe, splice can move the pipe buffers directly.
+    if (ret == -1 && is_transfer_unsupported(errno))
+        while ((ret = splice(source, nullptr, out, nullptr, length, SPLICE_F_MOVE)) == -1 && errno == EINTR)
+        {
+            // Retry in case we get interrupted by a signal.
+        }
+
+    return ret;
+#elif defined(ZIG_OS_MACOS)
+    while (true)
+    {
+        off_t sent = (off_t)length;
+
+        // macOS can only send files to sockets; anything else fails with ENOTSOCK.
+        if (sendfile(source, out, offset, &sent, nullptr, 0) != -1 || sent)
+            return (ssize_t)sent;
+
+        if (errno != EINTR)
+            return -1;
+    }
+#else
+    (void)out;
+    (void)source;
+    (void)offset;
+    (void)length;
+
+    errno = ENOSYS;
+
+    return -1;
+#endif
+}
+
+static ssize_t transfer_copy(int out, int source, off_t offset, size_t length)
+{
+    uint8_t buffer[65536];
+    size_t total = 0;
+
+    while (total < length)
+    {
+        size_t chunk = length - total < sizeof(buffer) ? length - total : sizeof(buffer);
+        bool seekable = true;
+        ssize_t ret;
+
+        while ((ret = pread(source, buffer, chunk, offset + (off_t)total)) == -1 && errno == EINTR)
+        {
+            // Retry in case we get interrupted by a signal.
+        }
+
+        if (ret == -1 && errno == ESPIPE)
+        {
+            seekable = false;
+
+            while ((ret = read(source, buffer, chunk)) == -1 && errno == EINTR)
+            {
+                // Retry in case we get interrupted by a signal.
+            }
+        }
+
+        // Report what we have managed to transfer so far, if anything; an error will resurface on the next call.
+        if (ret <= 0)
+            return total ? (ssize_t)total : ret;
+
+        size_t count = (size_t)ret;
+
+        for (size_t written = 0; written < count; written += (size_t)ret)
+        {
+            while ((ret = write(out, buffer + written, count - written)) == -1 && errno == EINTR)
+            {
+                // Retry in case we get interrupted by a signal.
+            }
+
+            if (ret == -1)
+            {
+                // Same as above. For a seekable source, the caller will pick up from where the write failed; for a
+                // pipe, the rest of this chunk is lost, but then the output is most likely unusable anyway.
+                if (errno != EAGAIN)
+                    return total + written ? (ssize_t)(total + written) : -1;
+
+                cathode_poll(true, &out, nullptr, 1);
+
+                ret = 0;
+            }
+        }
+
+        total += count;
+
+        // The caller waits for a pipe to become readable before calling us, without holding any locks. Reading from it
+        // again here could block indefinitely while the caller holds those locks.
+        if (!seekable)
+            break;
+    }
+
+    return (ssize_t)total;
+}
+
+TerminalResult cathode_transfer(
+    TerminalDescriptor *nonnull descriptor, int source, int64_t offset, int64_t length, int64_t *nonnull progress)
+{
+    assert(descriptor);
+    assert(offset >= 0);
+    assert(length >= 0);
+    assert(progress);
+
+    while (true)
+    {
+        int fd = get_fd(descriptor);
+        ssize_t ret = transfer_kernel(fd, source, (off_t)offset, (size_t)length);
+
+        if (ret == -1 && is_transfer_unsupported(errno))
+            ret = transfer_copy(fd, source, (off_t)offset, (size_t)length);
+
+        bool success = true;
+
+        // EPIPE means the descriptor was probably redirected to a program that ended. Pretend that we transferred
+        // everything since a progress of zero would indicate the end of the source.
+        if (ret != -1)
+            *progress = ret;
+        else if (errno == EPIPE)
+            *progress = length;
+        else
+            success = false;
+
+        // See cathode_write.
+        if (!success && errno == EAGAIN)
+        {
+            cathode_poll(true, &descriptor->fd, nullptr, 1);
+
+            continue;
+        }
+
+        return success
+            ? (TerminalResult)
+            {
+                .exception = TerminalException_None,
+            }
+            : (TerminalResult)
+            {
+                .exception = TerminalException_Terminal,
+                .message = u"Could not transfer data to output handle.",
+                .error = errno,
+            };
+    }
+}
+
 void cathode_poll(bool write, const int *nonnull fds, bool *nullable results, int count)
 {
     assert(fds);
@@ -446,4 +669,226 @@ void cathode_poll(bool write, const int *nonnull fds, bool *nullable results, in
             results[i] = pfds[i].revents & (write ? POLLOUT : POLLIN);
 }
 
+TerminalResult cathode_spawn(
+    const char *nonnull path,
+    const char *nonnull const *nonnull arguments,
+    const char *nonnull const *nonnull environment,
+    const char *nullable directory,
+    int in,
+    int out,
+    int err,
+    TerminalProcess *nonnull *nonnull process,
+    int32_t *nonnull id)
+{
+    assert(path);
+    assert(arguments);
+    assert(environment);
+    assert(process);
+    assert(id);
+
+    TerminalProcess *proc = malloc(sizeof(TerminalProcess));
+
+    if (!proc)
+        return (TerminalResult)
+        {
+            .exception = TerminalException_Terminal,
+            .message = u"Could not start child process.",
+            .error = ENOMEM,
+        };
+
+    const int targets[] = { STDIN_FILENO, STDOUT_FILENO, STDERR_FILENO };
+    int sources[] = { in, out, err };
+    int moved[] = { -1, -1, -1 };
+    posix_spawn_file_actions_t actions;
+    posix_spawnattr_t attributes;
+    sigset_t defaults;
+    int error = 0;
+
+    // The file actions are applied in order, so a source that is itself a standard descriptor could be clobbered by an
+    // earlier action. Moving such sources out of the way also takes care of clearing FD_CLOEXEC on them, which dup2 in
+    // the child does for us.
+    for (int i = 0; i < 3; i++)
+        if (sources[i] != -1 && sources[i] <= STDERR_FILENO)
+        {
+            if ((moved[i] = fcntl(sources[i], F_DUPFD_CLOEXEC, STDERR_FILENO + 1)) == -1)
+            {
+                error = errno;
+
+                goto done;
+            }
+
+            sources[i] = moved[i];
+        }
+
+    posix_spawn_file_actions_init(&actions);
+    posix_spawnattr_init(&attributes);
+
+    for (int i = 0; i < 3 && !error; i++)
+        if (sources[i] != -1)
+            error = posix_spawn_file_actions_adddup2(&actions, sources[i], targets[i]);
+
+    if (!error && directory)
+        error = posix_spawn_file_actions_addchdir_np(&actions, directory);
+
+    // Signal handlers are reset by exec, but ignored signals are not. The runtime ignores SIGPIPE, which would break
+    // the usual behavior of programs in a pipeline.
+    sigemptyset(&defaults);
+    sigaddset(&defaults, SIGPIPE);
+
+    if (!error)
+        error = posix_spawnattr_setsigdefault(&attributes, &defaults);
+
+    if (!error)
+        error = posix_spawnattr_setflags(&attributes, POSIX_SPAWN_SETSIGDEF);
+
+    clock_gettime(CLOCK_MONOTONIC, &proc->start);
+
+    // Unlike fork, posix_spawn does not copy the page tables of the parent (vfork semantics on Linux, a system call on
+    // macOS), so spawning does not get slower as the managed heap grows. It also reports exec failures directly.
+    if (!error)
+        error = posix_spawn(&proc->pid, path, &actions, &attributes, (char *const *)arguments, (char *const *)environment);
+
+    posix_spawnattr_destroy(&attributes);
+    posix_spawn_file_actions_destroy(&actions);
+
+done:
+    for (int i = 0; i < 3; i++)
+        if (moved[i] != -1)
+            close(moved[i]);
+
+    if (error)
+    {
+        free(proc);
+
+        return (TerminalResult)
+        {
+            .exception = TerminalException_Terminal,
+            .message = u"Could not start child process.",
+            .error = error,
+        };
+    }
+
+    *process = proc;
+    *id = proc->pid;
+
+    return (TerminalResult)
+    {
+        .exception = TerminalException_None,
+    };
+}
+
+bool cathode_has_exited(TerminalProcess *nonnull process)
+{
+    assert(process);
+
+    siginfo_t info = { 0 };
+    int ret;
+
+    // WNOWAIT leaves the process as a zombie so that its ID cannot be reused until we reap it.
+    while ((ret = waitid(P_PID, (id_t)process->pid, &info, WEXITED | WNOHANG | WNOWAIT)) == -1 && errno == EINTR)
+    {
+        // Retry in case we get interrupted by a signal.
+    }
+
+    // With WNOHANG, si_pid is left as zero while the process is still running. If the call fails (e.g. ECHILD because
+    // something else reaped the process), report it as exited so that cathode_reap gets to surface the error.
+    if (ret == 0 && !info.si_pid)
+        return false;
+
+    // This is as close to the actual exit time as we can get; the reap may happen a while later.
+    clock_gettime(CLOCK_MONOTONIC, &process->end);
+
+    return true;
+}
+
+TerminalResult cathode_kill(TerminalProcess *nonnull process)
+{
+    assert(process);
+
+    // The process has not been reaped yet, so its ID cannot have been reused. Killing a zombie is harmless.
+    if (kill(process->pid, SIGKILL) == -1 && errno != ESRCH)
+        return (TerminalResult)
+        {
+            .exception = TerminalException_Terminal,
+            .message = u"Could not kill child process.",
+            .error = errno,
+        };
+
+    return (TerminalResult)
+    {
+        .exception = TerminalException_None,
+    };
+}
+
+static int64_t timeval_to_ns(struct timeval value)
+{
+    return (int64_t)value.tv_sec * 1000000000 + (int64_t)value.tv_usec * 1000;
+}
+
+TerminalResult cathode_reap(
+    TerminalProcess *nonnull process, int32_t *nonnull code, TerminalProcessUsage *nonnull usage)
+{
+    assert(process);
+    assert(code);
+    assert(usage);
+
+    int status;
+    struct rusage rusage;
+    pid_t ret;
+
+    // wait4 gives us the resource usage of the process as part of reaping it, so there is no extra system call.
+    while ((ret = wait4(process->pid, &status, 0, &rusage)) == -1 && errno == EINTR)
+    {
+        // Retry in case we get interrupted by a signal.
+    }
+
+    if (ret == -1)
+    {
+        // Most likely ECHILD, meaning that the process was reaped behind our back (e.g. SIGCHLD is set to SIG_IGN), so
+        // its exit status and resource usage are gone.
+        int error = errno;
+
+        free(process);
+
+        return (TerminalResult)
+        {
+            .exception = TerminalException_Terminal,
+            .message = u"Could not retrieve child process exit status.",
+            .error = error,
+        };
+    }
+
+    // Follow the shell convention for processes that were terminated by a signal.
+    *code = WIFSIGNALED(status) ? 128 + WTERMSIG(status) : WEXITSTATUS(status);
+
+    *usage = (TerminalProcessUsage)
+    {
+        .elapsed_time =
+            (int64_t)(process->end.tv_sec - process->start.tv_sec) * 1000000000 +
+            (process->end.tv_nsec - process->start.tv_nsec),
+        .user_time = timeval_to_ns(rusage.ru_utime),
+        .system_time = timeval_to_ns(rusage.ru_stime),
+#if defined(ZIG_OS_MACOS)
+        .peak_memory = rusage.ru_maxrss,
+#else
+        // Linux reports this in kilobytes rather than bytes.
+        .peak_memory = (int64_t)rusage.ru_maxrss * 1024,
+#endif
+        .voluntary_switches = rusage.ru_nvcsw,
+        .involuntary_switches = rusage.ru_nivcsw,
+        .block_input_operations = rusage.ru_inblock,
+        .block_output_operations = rusage.ru_oublock,
+        // There is no per-process count of I/O calls; /proc/<pid>/io is gone once the process has been reaped.
+        .read_operations = -1,
+        .write_operations = -1,
+    };
+
+    free(process);
+
+    return (TerminalResult)
+    {
+        .exception = TerminalException_None,
+    };
+}
+
 #endif
@@ -5,3 +5,21 @@
 #include "driver.h"
 
 CATHODE_API void cathode_poll(bool write, const int *nonnull fds, bool *nullable results, int count);
+
+// Transfers at most length bytes from source to the descriptor, without copying through user space when the kernel
+// supports it for the given descriptors. A progress of zero means that the end of the source was reached. The offset is
+// ignored if the source is not seekable.
+CATHODE_API TerminalResult cathode_transfer(
+    TerminalDescriptor *nonnull descriptor, int source, int64_t offset, int64_t length, int64_t *nonnull progress);
+
+// The descriptors are duplicated onto the standard I/O descriptors of the child process; -1 means inherit.
+CATHODE_API TerminalResult cathode_spawn(
+    const char *nonnull path,
+    const char *nonnull const *nonnull arguments,
+    const char *nonnull const *nonnull environment,
+    const char *nullable directory,
+    int in,
+    int out,
+    int err,
+    TerminalProcess *nonnull *nonnull process,
+    int32_t *nonnull id);
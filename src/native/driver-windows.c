@@ -3,6 +3,7 @@
 #if defined(ZIG_OS_WINDOWS)
 
 #include <windows.h>
+#include <psapi.h>
 
 #include "driver-windows.h"
 
@@ -11,6 +12,11 @@ struct TerminalDescriptor
     HANDLE handle;
 };
 
+struct TerminalProcess
+{
+    HANDLE handle;
+};
+
 typedef struct
 {
     TerminalDescriptor descriptor;
@@ -23,6 +29,7 @@ static TerminalDescriptor stdio_out;
 static TerminalDescriptor stdio_err;
 static ConsoleState con_in;
 static ConsoleState con_out;
+static INIT_ONCE console_once = INIT_ONCE_STATIC_INIT;
 static bool original_state_saved;
 static bool raw_mode;
 
@@ -63,8 +70,6 @@ static void constructor(void)
     stdio_in.handle = open_stdio_handle(STD_INPUT_HANDLE);
     stdio_out.handle = open_stdio_handle(STD_OUTPUT_HANDLE);
     stdio_err.handle = open_stdio_handle(STD_ERROR_HANDLE);
-    con_in.descriptor.handle = open_console_handle(u"CONIN$");
-    con_out.descriptor.handle = open_console_handle(u"CONOUT$");
 }
 
 [[gnu::destructor]]
@@ -91,6 +96,25 @@ static void destructor(void)
         CloseHandle(out);
 }
 
+static BOOL CALLBACK open_console_handles(PINIT_ONCE, PVOID, PVOID *)
+{
+    con_in.descriptor.handle = open_console_handle(u"CONIN$");
+    con_out.descriptor.handle = open_console_handle(u"CONOUT$");
+
+    return true;
+}
+
+static HANDLE get_handle(const TerminalDescriptor *nonnull descriptor)
+{
+    assert(descriptor);
+
+    // Most programs never touch the console directly, so only open it once something actually needs it.
+    if (descriptor == &con_in.descriptor || descriptor == &con_out.descriptor)
+        InitOnceExecuteOnce(&console_once, open_console_handles, nullptr, nullptr);
+
+    return descriptor->handle;
+}
+
 void cathode_get_descriptors(
     TerminalDescriptor *nonnull *nonnull std_in,
     TerminalDescriptor *nonnull *nonnull std_out,
@@ -115,7 +139,9 @@ bool cathode_is_valid(const TerminalDescriptor *nonnull descriptor, bool write)
 {
     assert(descriptor);
 
-    if (!descriptor->handle)
+    HANDLE handle = get_handle(descriptor);
+
+    if (!handle)
         return false;
 
     // Apparently, for Windows GUI programs, the standard I/O handles will appear to be valid (i.e. not -1 or 0) but
@@ -124,7 +150,7 @@ bool cathode_is_valid(const TerminalDescriptor *nonnull descriptor, bool write)
     {
         DWORD written;
 
-        return WriteFile(descriptor->handle, nullptr, 0, &written, nullptr);
+        return WriteFile(handle, nullptr, 0, &written, nullptr);
     }
 
     return true;
@@ -134,10 +160,11 @@ bool cathode_is_interactive(const TerminalDescriptor *nonnull descriptor)
 {
     assert(descriptor);
 
+    HANDLE handle = get_handle(descriptor);
     DWORD mode;
 
     // Note that this also returns true for invalid handles.
-    return GetFileType(descriptor->handle) == FILE_TYPE_CHAR && GetConsoleMode(descriptor->handle, &mode);
+    return GetFileType(handle) == FILE_TYPE_CHAR && GetConsoleMode(handle, &mode);
 }
 
 bool cathode_query_size(int32_t *nonnull width, int32_t *nonnull height)
@@ -147,7 +174,7 @@ bool cathode_query_size(int32_t *nonnull width, int32_t *nonnull height)
 
     CONSOLE_SCREEN_BUFFER_INFO info;
 
-    if (!GetConsoleScreenBufferInfo(con_out.descriptor.handle, &info))
+    if (!GetConsoleScreenBufferInfo(get_handle(&con_out.descriptor), &info))
         return false;
 
     *width = info.srWindow.Right - info.srWindow.Left + 1;
@@ -163,8 +190,8 @@ bool cathode_get_mode(void)
 
 TerminalResult cathode_set_mode(bool raw, bool flush)
 {
-    HANDLE in = con_in.descriptor.handle;
-    HANDLE out = con_out.descriptor.handle;
+    HANDLE in = get_handle(&con_in.descriptor);
+    HANDLE out = get_handle(&con_out.descriptor);
 
     DWORD in_mode;
     DWORD out_mode;
@@ -344,7 +371,8 @@ TerminalResult cathode_read(
     assert(buffer);
     assert(progress);
 
-    return create_io_result(ReadFile(descriptor->handle, buffer, (DWORD)length, (LPDWORD)progress, nullptr), progress);
+    return create_io_result(
+        ReadFile(get_handle(descriptor), buffer, (DWORD)length, (LPDWORD)progress, nullptr), progress);
 }
 
 TerminalResult cathode_write(
@@ -354,13 +382,288 @@ TerminalResult cathode_write(
     assert(buffer);
     assert(progress);
 
-    return create_io_result(WriteFile(descriptor->handle, buffer, (DWORD)length, (LPDWORD)progress, nullptr), progress);
+    return create_io_result(
+        WriteFile(get_handle(descriptor), buffer, (DWORD)length, (LPDWORD)progress, nullptr), progress);
 }
 
 void cathode_cancel(TerminalDescriptor *nonnull descriptor)
 {
     // This is a best-effort situation; nothing we can do if this fails.
-    CancelIoEx(descriptor->handle, nullptr);
+    CancelIoEx(get_handle(descriptor), nullptr);
+}
+
+static bool add_handle(HANDLE handle, HANDLE *nonnull target, HANDLE *nonnull inherited, DWORD *nonnull count)
+{
+    assert(target);
+    assert(inherited);
+    assert(count);
+
+    // The child process can only use handles that are inheritable, but we do not want to make the parent's handles
+    // inheritable as other processes spawned concurrently could then inherit them. So make an inheritable copy.
+    if (!handle || handle == INVALID_HANDLE_VALUE)
+    {
+        *target = nullptr;
+
+        return true;
+    }
+
+    if (!DuplicateHandle(GetCurrentProcess(), handle, GetCurrentProcess(), target, 0, true, DUPLICATE_SAME_ACCESS))
+        return false;
+
+    inherited[(*count)++] = *target;
+
+    return true;
+}
+
+TerminalResult cathode_spawn(
+    wchar_t *nonnull command_line,
+    const wchar_t *nonnull environment,
+    const wchar_t *nullable directory,
+    bool create_window,
+    int32_t show,
+    HANDLE in,
+    HANDLE out,
+    HANDLE err,
+    TerminalProcess *nonnull *nonnull process,
+    int32_t *nonnull id)
+{
+    assert(command_line);
+    assert(environment);
+    assert(process);
+    assert(id);
+
+    TerminalResult result;
+    TerminalProcess *proc = HeapAlloc(GetProcessHeap(), 0, sizeof(TerminalProcess));
+    STARTUPINFOEXW info =
+    {
+        .StartupInfo =
+        {
+            .cb = sizeof(STARTUPINFOEXW),
+        },
+    };
+    HANDLE inherited[3];
+    DWORD count = 0;
+    bool attributes = false;
+
+    if (!proc)
+    {
+        SetLastError(ERROR_NOT_ENOUGH_MEMORY);
+
+        goto fail;
+    }
+
+    // The child gets the parent's standard handles for anything that is not redirected, as it would normally. This has
+    // to be done explicitly even if nothing is redirected, since we restrict handle inheritance below; otherwise, the
+    // child would lose the parent's standard handles if those refer to files or pipes.
+    if (!add_handle(in ? in : GetStdHandle(STD_INPUT_HANDLE), &info.StartupInfo.hStdInput, inherited, &count) ||
+        !add_handle(out ? out : GetStdHandle(STD_OUTPUT_HANDLE), &info.StartupInfo.hStdOutput, inherited, &count) ||
+        !add_handle(err ? err : GetStdHandle(STD_ERROR_HANDLE), &info.StartupInfo.hStdError, inherited, &count))
+        goto fail;
+
+    // If the parent has no standard handles at all (e.g. a GUI program), let the child set up its own.
+    if (count)
+        info.StartupInfo.dwFlags |= STARTF_USESTDHANDLES;
+
+    if (show >= 0)
+    {
+        info.StartupInfo.dwFlags |= STARTF_USESHOWWINDOW;
+        info.StartupInfo.wShowWindow = (WORD)show;
+    }
+
+    // Restrict inheritance to exactly the standard handles that we set up above.
+    if (count)
+    {
+        SIZE_T size = 0;
+
+        InitializeProcThreadAttributeList(nullptr, 1, 0, &size);
+
+        if (!(info.lpAttributeList = HeapAlloc(GetProcessHeap(), 0, size)))
+        {
+            SetLastError(ERROR_NOT_ENOUGH_MEMORY);
+
+            goto fail;
+        }
+
+        if (!(attributes = InitializeProcThreadAttributeList(info.lpAttributeList, 1, 0, &size)))
+            goto fail;
+
+        if (!UpdateProcThreadAttribute(
+            info.lpAttributeList,
+            0,
+            PROC_THREAD_ATTRIBUTE_HANDLE_LIST,
+            inherited,
+            count * sizeof(HANDLE),
+            nullptr,
+            nullptr))
+            goto fail;
+    }
+
+    DWORD flags = CREATE_UNICODE_ENVIRONMENT;
+
+    if (attributes)
+        flags |= EXTENDED_STARTUPINFO_PRESENT;
+
+    if (!create_window)
+        flags |= CREATE_NO_WINDOW;
+
+    PROCESS_INFORMATION pi;
+
+    if (!CreateProcessW(
+        nullptr,
+        command_line,
+        nullptr,
+        nullptr,
+        attributes,
+        flags,
+        (void *)environment,
+        directory,
+        &info.StartupInfo,
+        &pi))
+        goto fail;
+
+    CloseHandle(pi.hThread);
+
+    proc->handle = pi.hProcess;
+
+    *process = proc;
+    *id = (int32_t)pi.dwProcessId;
+
+    result = (TerminalResult)
+    {
+        .exception = TerminalException_None,
+    };
+
+    goto done;
+
+fail:
+    result = (TerminalResult)
+    {
+        .exception = TerminalException_Terminal,
+        .message = u"Could not start child process.",
+        .error = (int32_t)GetLastError(),
+    };
+
+    if (proc)
+        HeapFree(GetProcessHeap(), 0, proc);
+
+done:
+    if (attributes)
+        DeleteProcThreadAttributeList(info.lpAttributeList);
+
+    if (info.lpAttributeList)
+        HeapFree(GetProcessHeap(), 0, info.lpAttributeList);
+
+    for (DWORD i = 0; i < count; i++)
+        CloseHandle(inherited[i]);
+
+    return result;
+}
+
+bool cathode_has_exited(TerminalProcess *nonnull process)
+{
+    assert(process);
+
+    return WaitForSingleObject(process->handle, 0) == WAIT_OBJECT_0;
+}
+
+TerminalResult cathode_kill(TerminalProcess *nonnull process)
+{
+    assert(process);
+
+    // Use the same exit code as System.Diagnostics.Process. Termination fails with access denied if the process has
+    // already exited, which is not an error here.
+    if (!TerminateProcess(process->handle, (UINT)-1))
+    {
+        DWORD error = GetLastError();
+
+        if (!cathode_has_exited(process))
+            return (TerminalResult)
+            {
+                .exception = TerminalException_Terminal,
+                .message = u"Could not kill child process.",
+                .error = (int32_t)error,
+            };
+    }
+
+    return (TerminalResult)
+    {
+        .exception = TerminalException_None,
+    };
+}
+
+HANDLE cathode_get_process_handle(TerminalProcess *nonnull process)
+{
+    assert(process);
+
+    return process->handle;
+}
+
+static int64_t filetime_to_ns(FILETIME value)
+{
+    return (int64_t)(((uint64_t)value.dwHighDateTime << 32) | value.dwLowDateTime) * 100;
+}
+
+TerminalResult cathode_reap(
+    TerminalProcess *nonnull process, int32_t *nonnull code, TerminalProcessUsage *nonnull usage)
+{
+    assert(process);
+    assert(code);
+    assert(usage);
+
+    DWORD status;
+
+    if (!GetExitCodeProcess(process->handle, &status))
+    {
+        DWORD error = GetLastError();
+
+        CloseHandle(process->handle);
+        HeapFree(GetProcessHeap(), 0, process);
+
+        return (TerminalResult)
+        {
+            .exception = TerminalException_Terminal,
+            .message = u"Could not retrieve child process exit status.",
+            .error = (int32_t)error,
+        };
+    }
+
+    *code = (int32_t)status;
+
+    FILETIME creation_time = { 0 };
+    FILETIME exit_time = { 0 };
+    FILETIME kernel_time = { 0 };
+    FILETIME user_time = { 0 };
+    PROCESS_MEMORY_COUNTERS memory = { .cb = sizeof(PROCESS_MEMORY_COUNTERS) };
+    IO_COUNTERS io = { 0 };
+
+    // The process object retains all of this information until we close our handle to it.
+    GetProcessTimes(process->handle, &creation_time, &exit_time, &kernel_time, &user_time);
+    K32GetProcessMemoryInfo(process->handle, &memory, sizeof(memory));
+    GetProcessIoCounters(process->handle, &io);
+
+    *usage = (TerminalProcessUsage)
+    {
+        .elapsed_time = filetime_to_ns(exit_time) - filetime_to_ns(creation_time),
+        .user_time = filetime_to_ns(user_time),
+        .system_time = filetime_to_ns(kernel_time),
+        .peak_memory = (int64_t)memory.PeakWorkingSetSize,
+        // Windows does not track context switches per process.
+        .voluntary_switches = -1,
+        .involuntary_switches = -1,
+        // Windows counts I/O calls regardless of whether they hit storage, so there are no block counts.
+        .block_input_operations = -1,
+        .block_output_operations = -1,
+        .read_operations = (int64_t)io.ReadOperationCount,
+        .write_operations = (int64_t)io.WriteOperationCount,
+    };
+
+    CloseHandle(process->handle);
+    HeapFree(GetProcessHeap(), 0, process);
+
+    return (TerminalResult)
+    {
+        .exception = TerminalException_None,
+    };
 }
 
 #endif
@@ -5,3 +5,20 @@
 #include "driver.h"
 
 CATHODE_API void cathode_cancel(TerminalDescriptor *nonnull descriptor);
+
+// The handles are made inheritable and passed as the standard I/O handles of the child process; a null handle means
+// inherit. A negative show value means that the window style is left up to the child process.
+CATHODE_API TerminalResult cathode_spawn(
+    wchar_t *nonnull command_line,
+    const wchar_t *nonnull environment,
+    const wchar_t *nullable directory,
+    bool create_window,
+    int32_t show,
+    HANDLE in,
+    HANDLE out,
+    HANDLE err,
+    TerminalProcess *nonnull *nonnull process,
+    int32_t *nonnull id);
+
+// Returns the process handle, which becomes signaled when the process exits. It is closed by cathode_reap.
+CATHODE_API HANDLE cathode_get_process_handle(TerminalProcess *nonnull process);
@@ -4,6 +4,8 @@
 
 typedef struct TerminalDescriptor TerminalDescriptor;
 
+typedef struct TerminalProcess TerminalProcess;
+
 typedef enum
 {
     TerminalException_None,
@@ -22,6 +24,21 @@ typedef struct
     int32_t error;
 } TerminalResult;
 
+// Times are in nanoseconds and sizes are in bytes. Counters that the platform does not track are -1.
+typedef struct
+{
+    int64_t elapsed_time;
+    int64_t user_time;
+    int64_t system_time;
+    int64_t peak_memory;
+    int64_t voluntary_switches;
+    int64_t involuntary_switches;
+    int64_t block_input_operations; // Blocks read from storage (Unix).
+    int64_t block_output_operations; // Blocks written to storage (Unix).
+    int64_t read_operations; // Read I/O calls of any kind (Windows).
+    int64_t write_operations; // Write I/O calls of any kind (Windows).
+} TerminalProcessUsage;
+
 // Keep in sync with src/core/TerminalSignal.cs (public API).
 typedef enum
 {
@@ -58,3 +75,16 @@ CATHODE_API TerminalResult cathode_read(
 
 CATHODE_API TerminalResult cathode_write(
     TerminalDescriptor *nonnull descriptor, const uint8_t *nullable buffer, int32_t length, int32_t *nonnull progress);
+
+// Checks whether the process has exited without blocking, and without releasing it. The process ID remains valid until
+// cathode_reap is called, which makes it safe to signal the process in the meantime.
+CATHODE_API bool cathode_has_exited(TerminalProcess *nonnull process);
+
+// Forcibly terminates the process, which must not have been reaped yet. Does nothing if it has already exited.
+CATHODE_API TerminalResult cathode_kill(TerminalProcess *nonnull process);
+
+// Releases all resources associated with the process, which must have exited. Resource usage is collected as part of
+// this, so it covers the entire lifetime of the process. The resources are released even if the exit status cannot be
+// retrieved, e.g. because something else reaped the process.
+CATHODE_API TerminalResult cathode_reap(
+    TerminalProcess *nonnull process, int32_t *nonnull code, TerminalProcessUsage *nonnull usage);
@@ -52,3 +52,31 @@ finally
 }
 
 await OutLineAsync($"Captured output: {(await echo.StandardOut.TextReader.ReadToEndAsync()).Trim()}");
+
+await OutLineAsync("Launching 'echo' piped to 'tr'...");
+
+var pipeline =
+    new ChildProcessBuilder()
+        .WithFileName("echo")
+        .WithArguments("hello", "world")
+        .PipeTo(
+            new ChildProcessBuilder()
+                .WithFileName("tr")
+                .WithArguments("a-z", "A-Z"))
+        .Run();
+
+await OutLineAsync($"Pipeline exited with code: {await pipeline.Completion}");
+await OutLineAsync($"Captured output: {(await pipeline.StandardOut.TextReader.ReadToEndAsync()).Trim()}");
+
+await OutLineAsync("Scheduling 'echo' and 'cat' with prefixed output...");
+
+var scheduler = new ChildProcessScheduler(maxParallelism: 2);
+
+// 'cat' reads its standard input; the scheduler closes it so that the job finishes instead of waiting forever.
+var jobs = await Task.WhenAll(
+    scheduler.Schedule(
+        new ChildProcessBuilder().WithFileName("echo").WithArguments("hello", "world"), "[echo] ", Color.Green),
+    scheduler.Schedule(new ChildProcessBuilder().WithFileName("cat"), "[cat] ", Color.Blue));
+
+foreach (var job in jobs)
+    await OutLineAsync($"Scheduled job exited with code: {await job.Completion}");
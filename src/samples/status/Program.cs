@@ -0,0 +1,30 @@
+// SPDX-License-Identifier: 0BSD
+
+using Vezel.Cathode.Text;
+
+const int Steps = 200;
+
+using var region = new LiveRegion(height: 2);
+
+var rng = new Random();
+
+for (var i = 1; i <= Steps; i++)
+{
+    // Regular output scrolls above the region while the region itself stays pinned to the bottom of the screen.
+    if (i % 10 == 0)
+        await OutLineAsync($"Finished step {i}.");
+
+    var width = Size.Width / 2;
+    var filled = width * i / Steps;
+
+    region[0] = $"[{new string('#', filled)}{new string('.', width - filled)}] {i}/{Steps}";
+    region[1] = $"Working on step {i}...";
+
+    [SuppressMessage("", "CA5394")]
+    int PickDelay()
+    {
+        return rng.Next(5, 30);
+    }
+
+    await Task.Delay(PickDelay());
+}
@@ -1,5 +1,21 @@
 // SPDX-License-Identifier: 0BSD
 
+using Vezel.Cathode;
+
+// The startup benchmark in build.cake launches this program with the time at which it was started and measures how
+// long it takes until the first write to the terminal has completed. This covers runtime startup, loading the native
+// library, and setting up Terminal.System.
+if (args is ["startup", var launched])
+{
+    Terminal.OutLine("Startup benchmark run.");
+
+    var elapsed = DateTime.UtcNow - new DateTime(long.Parse(launched, CultureInfo.InvariantCulture), DateTimeKind.Utc);
+
+    Terminal.ErrorLine(elapsed.TotalMilliseconds.ToString(CultureInfo.InvariantCulture));
+
+    return 0;
+}
+
 Console.WriteLine("What are you doing? 👀");
 
 return 1;